@@ -31,6 +31,9 @@
  *     v1.0 - First release
  *     v1.A - Converted to eliminate floating point values and functions
  *            By Greg Aicklen (2024)
+ *     v1.B - Skip the reset in begin() when the sensor is already in its
+ *            power-on state; write the whole Config register at once
+ *     v1.C - Correct the alert polarity descriptions (normal is active low)
  */
 
 #include "Arduino.h"
@@ -76,8 +79,12 @@ bool Adafruit_INA260::begin(uint8_t i2c_address, TwoWire *theWire) {
   AlertLimit =
       new Adafruit_I2CRegister(i2c_dev, INA260_REG_ALERT_LIMIT, 2, MSBFIRST);
 
-  reset();
-  delay(2); // delay 2ms to give time for first measurement to finish
+  // A sensor that has just powered up is already in its reset state, and
+  // converting; only reset (and wait for the first conversion) otherwise
+  if (Config->read() != INA260_CONFIG_DEFAULT) {
+    reset();
+    delay(2); // delay 2ms to give time for first measurement to finish
+  }
   return true;
 }
 /**************************************************************************/
@@ -156,6 +163,36 @@ void Adafruit_INA260::setMode(INA260_MeasurementMode new_mode) {
   mode.write(new_mode);
 }
 /**************************************************************************/
+/*!
+    @brief Sets the averaging count, conversion times and mode together, with
+    a single write of the Config register; nothing is written if the register
+    already holds the new configuration.
+    @param count
+           The number of samples to be averaged
+    @param voltage_time
+           The new bus voltage conversion time
+    @param current_time
+           The new current conversion time
+    @param new_mode
+           The new measurement mode
+    @return True if the Config register was written (which restarts conversion)
+*/
+/**************************************************************************/
+bool Adafruit_INA260::setConfig(INA260_AveragingCount count,
+                                INA260_ConversionTime voltage_time,
+                                INA260_ConversionTime current_time,
+                                INA260_MeasurementMode new_mode) {
+  uint16_t config = Config->read();
+  uint16_t value = (config & INA260_CONFIG_RESERVED) | ((uint16_t)count << 9) |
+                   ((uint16_t)voltage_time << 6) |
+                   ((uint16_t)current_time << 3) | new_mode;
+  if (value == config) {
+    return false;
+  }
+  Config->write(value);
+  return true;
+}
+/**************************************************************************/
 /*!
     @brief Reads the current number of averaging samples
     @return The current number of averaging samples
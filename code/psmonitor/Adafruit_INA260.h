@@ -34,6 +34,9 @@
 #define INA260_REG_MFG_UID 0xFE     ///< Manufacturer ID Register
 #define INA260_REG_DIE_UID 0xFF     ///< Die ID and Revision Register
 
+#define INA260_CONFIG_DEFAULT 0x6127  ///< Config register after power-on or reset
+#define INA260_CONFIG_RESERVED 0x7000 ///< Reserved bits of the Config register
+
 /**
  * @brief Mode options.
  *
@@ -104,8 +107,8 @@ typedef enum _alert_type {
  * Allowed values for setAlertPolarity.
  */
 typedef enum _alert_polarity {
-  INA260_ALERT_POLARITY_NORMAL = 0x0, ///< Active high open-collector (Default)
-  INA260_ALERT_POLARITY_INVERTED = 0x1, ///< Active low open-collector
+  INA260_ALERT_POLARITY_NORMAL = 0x0, ///< Active low open-collector (Default)
+  INA260_ALERT_POLARITY_INVERTED = 0x1, ///< Active high open-collector
 } INA260_AlertPolarity;
 
 /**
@@ -158,6 +161,10 @@ public:
   void setVoltageConversionTime(INA260_ConversionTime time);
   INA260_AveragingCount getAveragingCount(void);
   void setAveragingCount(INA260_AveragingCount count);
+  bool setConfig(INA260_AveragingCount count,
+                 INA260_ConversionTime voltage_time,
+                 INA260_ConversionTime current_time,
+                 INA260_MeasurementMode new_mode = INA260_MODE_CONTINUOUS);
 
   Adafruit_I2CRegister *Config, ///< BusIO Register for Config
       *MaskEnable,              ///< BusIO Register for MaskEnable
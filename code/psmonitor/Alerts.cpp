@@ -0,0 +1,221 @@
+/**
+ * @file Alerts.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Evaluates configurable over/under limit rules against voltage and current readings.
+ *
+ * Implements a table of alert rules, each comparing one channel of a set of readings against a
+ * threshold. A rule raises its alert once the threshold has been exceeded for at least the
+ * rule's duration, and clears it only when the reading is back inside the threshold by the
+ * rule's hysteresis, so a reading sitting on a limit does not chirp on and off.
+ *
+ * Rules are stored in EEPROM (with a CRC) and can be changed at runtime; if no valid rules
+ * are stored, defaults derived from limits.h are used: the voltage of each output, away from
+ * common, then both directions of the current of each output (currents can go either way)
+ * for as many outputs as there are rules left.
+ *
+ * To use the alert rules:
+ *      - Alerts::setup() - load the rule table from EEPROM
+ *      - Alerts::evaluate() - evaluate all rules against a set of readings
+ *      - Alerts::active() - bit mask of rules currently alerting
+ *      - Alerts::getRule() / Alerts::setRule() - inspect or change a rule
+ *      - Alerts::save() - queue the rule table to be written to EEPROM
+ */
+
+// Standard header files
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stddef.h>
+
+// Include our own header file
+#include "Alerts.h"
+
+// MonitorTask header to include MONITOR_* enums
+#include "MonitorTask.h"
+
+// Limits on power supply output voltages and currents
+#include "limits.h"
+
+// EEPROM layout, CRC used to validate EEPROM data, and deferred writing
+#include "eeprom_map.h"
+#include "Crc16.h"
+#include "EepromWriter.h"
+
+namespace Alerts {
+
+    // Rule table as stored in EEPROM
+    struct rule_table {
+        alert_rule rules[ALERT_RULES];
+        uint16_t crc;
+    };
+    constexpr uint16_t crc_length = offsetof(rule_table, crc);
+    static_assert(sizeof(rule_table) <= EEPROM_ALERT_RULES_END - EEPROM_ALERT_RULES, "Alert rules must fit in their EEPROM space");
+
+    rule_table table;
+
+    // Rule state, one bit per rule
+    auto pendingMask = alert_mask{0};   // Threshold exceeded; waiting out the duration
+    auto activeMask = alert_mask{0};    // Alerting
+    uint16_t onset[ALERT_RULES];      // Low 16 bits of millis() when the threshold was first exceeded
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      void defaults(void);
+
+    }
+
+    /**
+    * @brief Loads the rule table from EEPROM, or the default rules if EEPROM holds no valid table.
+    *
+    * The default rules depend on which outputs are negative, so MonitorTask::setup() must
+    * have been called.
+    */
+    void setup(void) {
+        EEPROM.get(EEPROM_ALERT_RULES, table);
+        if (table.crc != Crc16::compute(reinterpret_cast<uint8_t*>(&table), crc_length)) {
+            defaults();
+        }
+        pendingMask = 0;
+        activeMask = 0;
+    }
+
+    /**
+    * @brief Evaluates every rule against a set of readings.
+    *
+    * A single pass over the rule table. Under rules are mirrored (reading and threshold
+    * complemented: ~x is -x - 1, so it never overflows and keeps the order reversed) so
+    * that every rule reduces to the same "greater than" test.
+    *
+    * @param values   Array of readings indexed by MONITOR_SELECT_GROUP + output
+    *
+    * @return Bit mask of rules currently alerting
+    */
+    alert_mask evaluate(const int16_t values[]) {
+        const uint16_t now = static_cast<uint16_t>(millis());
+        auto mask = alert_mask{1};
+        for (auto index = uint8_t{0}; index < ALERT_RULES; index++, mask <<= 1) {
+            const alert_rule &rule = table.rules[index];
+            if (rule.type == ALERT_OFF) {
+                continue;
+            }
+
+            // 0 for over rules, -1 for under rules; x ^ sign complements x for under rules.
+            // setRule() keeps threshold - hysteresis in range.
+            const int16_t sign = -static_cast<int16_t>(rule.type == ALERT_UNDER);
+            const int16_t value = values[rule.channel] ^ sign;
+            const int16_t threshold = rule.threshold ^ sign;
+
+            if (activeMask & mask) {
+                if (value <= threshold - rule.hysteresis) {
+                    activeMask &= ~mask;
+                }
+            }
+            else if (value > threshold) {
+                if (!(pendingMask & mask)) {
+                    pendingMask |= mask;
+                    onset[index] = now;
+                }
+                if (static_cast<uint16_t>(now - onset[index]) >= rule.duration) {
+                    activeMask |= mask;
+                    pendingMask &= ~mask;
+                }
+            }
+            else {
+                pendingMask &= ~mask;
+            }
+        }
+        return activeMask;
+    }
+
+    /**
+    * @brief Returns the rules currently alerting.
+    *
+    * @return Bit mask of rules currently alerting (bit n for rule n)
+    */
+    alert_mask active(void) {
+        return activeMask;
+    }
+
+    /**
+    * @brief Retrieves a rule from the rule table.
+    *
+    * @param index       Rule number
+    * @param[out] rule   Returns the rule
+    *
+    * @return False if the rule number is out of range
+    */
+    bool getRule(const uint8_t index, alert_rule &rule) {
+        if (index >= ALERT_RULES) {
+            return false;
+        }
+        rule = table.rules[index];
+        return true;
+    }
+
+    /**
+    * @brief Replaces a rule in the rule table; the change is not persistent until save().
+    *
+    * @param index   Rule number
+    * @param rule    New rule
+    *
+    * @return False if the rule number or contents are out of range, or the hysteresis takes
+    *         the level at which the alert clears beyond the range of a reading
+    */
+    bool setRule(const uint8_t index, const alert_rule &rule) {
+        if (index >= ALERT_RULES || rule.channel >= MONITOR_VALUES || rule.type > ALERT_UNDER || rule.hysteresis < 0) {
+            return false;
+        }
+        // The alert clears at the threshold less the hysteresis (mirrored for under rules, as in evaluate())
+        const int16_t threshold = (rule.type == ALERT_UNDER) ? ~rule.threshold : rule.threshold;
+        if (static_cast<int32_t>(threshold) - rule.hysteresis < INT16_MIN) {
+            return false;
+        }
+        table.rules[index] = rule;
+        pendingMask &= ~(1 << index);
+        activeMask &= ~(1 << index);
+        return true;
+    }
+
+    /**
+    * @brief Queues the rule table to be written to EEPROM; EepromWriter::busy() until written.
+    *
+    * Only bytes that have changed are written.
+    */
+    void save(void) {
+        table.crc = Crc16::compute(reinterpret_cast<uint8_t*>(&table), crc_length);
+        EepromWriter::put(EEPROM_ALERT_RULES, &table, sizeof(table));
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      /**
+      * @brief Fills the rule table with the default rules.
+      *
+      */
+      void defaults(void) {
+          static_assert(ALERT_RULES >= 3 * MONITOR_OUTPUTS, "Every output must get its default rules");
+          auto index = uint8_t{0};
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS && index < ALERT_RULES; output++, index++) {
+              table.rules[index] = MonitorTask::negative(output) ?
+                  alert_rule{static_cast<uint8_t>(MONITOR_VOLTAGE + output), ALERT_UNDER, -LIMIT_MAX_VOLTAGE, LIMIT_HYSTERESIS_VOLTAGE, 0} :
+                  alert_rule{static_cast<uint8_t>(MONITOR_VOLTAGE + output), ALERT_OVER, LIMIT_MAX_VOLTAGE, LIMIT_HYSTERESIS_VOLTAGE, 0};
+          }
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS && index + 1 < ALERT_RULES; output++, index += 2) {
+              const auto channel = static_cast<uint8_t>(MONITOR_CURRENT + output);
+              table.rules[index] = {channel, ALERT_OVER, LIMIT_MAX_CURRENT, LIMIT_HYSTERESIS_CURRENT, 0};
+              table.rules[index + 1] = {channel, ALERT_UNDER, -LIMIT_MAX_CURRENT, LIMIT_HYSTERESIS_CURRENT, 0};
+          }
+          for (; index < ALERT_RULES; index++) {
+              table.rules[index] = {0, ALERT_OFF, 0, 0, 0};
+          }
+      }
+
+    }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+/**
+ * @file Alerts.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining configurable alert rules.
+ *
+ */
+
+#ifndef _ALERTS_H
+#define _ALERTS_H
+
+// MONITOR_OUTPUTS
+#include "MonitorTask.h"
+
+// Alert rule types
+enum ALERT_TYPE : uint8_t {
+    ALERT_OFF = 0,      // Rule disabled
+    ALERT_OVER = 1,     // Alert while reading is above threshold
+    ALERT_UNDER = 2,    // Alert while reading is below threshold
+};
+
+// Number of rules in the rule table: at least 8, and room for the default rules (three per output)
+constexpr uint8_t ALERT_RULES = (3 * MONITOR_OUTPUTS > 8) ? 3 * MONITOR_OUTPUTS : 8;
+
+// Rules alerting (or in any other state), bit n for rule n
+using alert_mask = uint16_t;
+static_assert(ALERT_RULES <= 8 * sizeof(alert_mask), "Each rule must have a bit in an alert_mask");
+
+/// An alert rule; applies to one channel of a set of readings
+struct alert_rule {
+    uint8_t channel;      // Index into a set of readings (MONITOR_SELECT_GROUP + output)
+    uint8_t type;         // ALERT_TYPE
+    int16_t threshold;    // Alert threshold in millivolts or milliamps
+    int16_t hysteresis;   // Distance back inside the threshold at which the alert clears
+    uint16_t duration;    // Time in milliseconds the threshold must be exceeded before alerting
+};
+
+namespace Alerts {
+
+    void setup(void);
+    alert_mask evaluate(const int16_t values[]);
+    alert_mask active(void);
+
+    bool getRule(const uint8_t index, alert_rule &rule);
+    bool setRule(const uint8_t index, const alert_rule &rule);
+    void save(void);
+
+}
+
+#endif
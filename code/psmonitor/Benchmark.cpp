@@ -0,0 +1,400 @@
+/**
+ * @file Benchmark.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Counts CPU cycles taken by the hot path routines and by each pass of the scheduler loop.
+ *
+ * While counting, Timer1 runs free at the CPU clock, extended to 32 bits by counting overflows,
+ * so cycles() reads an exact cycle count. (Timer1 is otherwise unused by this firmware.) The
+ * counter only runs while the benchmarks run, unless BENCHMARK_LOOP_PROFILING is defined; then
+ * it runs from setup() on, at the cost of an overflow interrupt every 4.1ms.
+ *
+ * Each benchmark calls one routine BENCHMARK_CALLS times with inputs the compiler cannot
+ * fold away, timing each call. The fewest cycles of any call, less the cost of timing an
+ * empty call, is reported: interrupts are left running, and the fastest call is the one
+ * no interrupt landed in, so the result is exact for routines that always take the same path.
+ * A benchmark blocks for its whole run, so benchmarks are only run on request.
+ *
+ * With BENCHMARK_LOOP_PROFILING defined, the scheduler loop marks the start of each pass; the
+ * cycles taken by each pass are kept as a running mean and a maximum for each operating mode.
+ * Otherwise loopMark() compiles to nothing and no loop statistics are kept.
+ *
+ * Startup is profiled by marking the end of each phase (BOOT_PHASE) with micros(), since the
+ * cycle counter is not running yet at the start and would wrap during a long startup.
+ *
+ * To use the benchmarks:
+ *      - Benchmark::setup() - start the cycle counter, if profiling the scheduler loop
+ *      - Benchmark::cycles() - read the cycle counter, while it runs
+ *      - Benchmark::count() - number of benchmarks
+ *      - Benchmark::name() - name of a benchmark
+ *      - Benchmark::run() - run a benchmark
+ *      - Benchmark::loopMark() - call at the start of each pass of the scheduler loop
+ *      - Benchmark::loopMean() / Benchmark::loopMax() - cycles per loop pass in a mode
+ *      - Benchmark::resetLoop() - clear the loop statistics
+ *      - Benchmark::bootMark() - mark the end of a startup phase
+ *      - Benchmark::bootTime() / Benchmark::bootPhaseName() - when each startup phase ended
+ */
+
+// Include standard headers as needed
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+
+// Include our own header file
+#include "Benchmark.h"
+
+// External storage shared between tasks
+#include "globals.h"
+
+// Include the routines being timed
+#include "Calibration.h"
+#include "Crc16.h"
+#include "Fixed.h"
+#include "MonitorTask.h"
+
+namespace Benchmark {
+
+    // High 16 bits of the cycle counter; Timer1 holds the low 16 bits
+    volatile uint16_t overflows = 0;
+
+#ifdef BENCHMARK_LOOP_PROFILING
+    // Loop statistics for each mode (STATE)
+    constexpr uint8_t LOOP_MEAN_SHIFT = 4;      // Running mean weights each pass 1/16
+    uint32_t loopMeans[MODE_COUNT] = {};        // Scaled by 2^LOOP_MEAN_SHIFT
+    uint32_t loopMaxima[MODE_COUNT] = {};
+    auto loopStart = uint32_t{0};
+    auto loopMode = uint8_t{MODE_COUNT};        // Mode of the pass in progress; none before the first mark
+#endif
+
+    // Time each startup phase (BOOT_PHASE) ended, in microseconds; 0 until marked
+    uint32_t bootTimes[BOOT_PHASES] = {};
+
+    // Startup phase names
+    const char bootWatchdog[] PROGMEM = "WATCHDOG";
+    const char bootSensors[] PROGMEM = "SENSORS";
+    const char bootLcd[] PROGMEM = "LCD";
+    const char bootTasks[] PROGMEM = "TASKS";
+    const char bootCalibration[] PROGMEM = "CALIBRATION";
+    const char bootAlerts[] PROGMEM = "ALERTS";
+    const char bootFirstReading[] PROGMEM = "FIRST READING";
+    const char bootPreciseReading[] PROGMEM = "PRECISE READING";
+    const char *const bootPhaseNames[BOOT_PHASES] PROGMEM = {bootWatchdog, bootSensors, bootLcd, bootTasks,
+                                                            bootCalibration, bootAlerts, bootFirstReading,
+                                                            bootPreciseReading};
+
+    /// Entry in the benchmark table
+    struct benchmark {
+        const char *name;           // Benchmark name, in program memory
+        void (*body)(void);         // Makes one call of the routine being timed
+    };
+
+    // Inputs and result; volatile so each call is made in full
+    volatile int16_t input16 = 12345;
+    volatile fixed inputFixed = Fixed::int2fixed(3) + Fixed::fixed_one / 3;
+    volatile int32_t sink;
+    uint8_t crcData[16] = {};
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      void empty(void);
+      void nearest10(void);
+      void voltageString(void);
+      void multiply(void);
+      void invert(void);
+      void correct(void);
+      void crc16(void);
+      void scaleCurrent(void);
+      void readFrame(void);
+
+      // Benchmark names
+      const char nameNearest10[] PROGMEM = "nearest10";
+      const char nameVoltageString[] PROGMEM = "generateVoltageString";
+      const char nameMultiply[] PROGMEM = "Fixed::multiply";
+      const char nameInvert[] PROGMEM = "Fixed::invert";
+      const char nameCorrect[] PROGMEM = "Calibration::correct";
+      const char nameCrc16[] PROGMEM = "Crc16::compute(16)";
+      const char nameScaleCurrent[] PROGMEM = "current scaling";
+      const char nameReadFrame[] PROGMEM = "MonitorTask::readFrame";
+
+      // Benchmark table
+      const benchmark benchmarks[] PROGMEM = {
+          {nameNearest10, nearest10},
+          {nameVoltageString, voltageString},
+          {nameMultiply, multiply},
+          {nameInvert, invert},
+          {nameCorrect, correct},
+          {nameCrc16, crc16},
+          {nameScaleCurrent, scaleCurrent},
+          {nameReadFrame, readFrame},
+      };
+
+      uint32_t timeCalls(void (*body)(void));
+      void startCounter(void);
+#ifndef BENCHMARK_LOOP_PROFILING
+      void stopCounter(void);
+#endif
+
+    }
+
+    /**
+    * @brief Starts Timer1 counting CPU cycles if the scheduler loop is profiled; otherwise
+    *        it is only started by run().
+    *
+    */
+    void setup(void) {
+#ifdef BENCHMARK_LOOP_PROFILING
+        startCounter();
+#endif
+    }
+
+    /**
+    * @brief Reads the cycle counter.
+    *
+    * @return CPU cycles since the counter was started, modulo 2^32 (about 268 seconds at 16MHz)
+    */
+    uint32_t cycles(void) {
+        uint16_t low;
+        uint16_t high;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            low = TCNT1;
+            high = overflows;
+            // An overflow not yet serviced belongs to this reading if the count has wrapped
+            if ((TIFR1 & bit(TOV1)) && low < 0x8000) {
+                high++;
+            }
+        }
+        return (static_cast<uint32_t>(high) << 16) | low;
+    }
+
+    /**
+    * @brief Gets the number of benchmarks.
+    *
+    */
+    uint8_t count(void) {
+        return sizeof(benchmarks) / sizeof(benchmarks[0]);
+    }
+
+    /**
+    * @brief Gets the name of a benchmark.
+    *
+    * @param index   Benchmark number, 0 - count() - 1
+    *
+    * @return Name, in program memory
+    */
+    const __FlashStringHelper *name(const uint8_t index) {
+        return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&benchmarks[index].name));
+    }
+
+    /**
+    * @brief Runs a benchmark.
+    *
+    * @param index   Benchmark number, 0 - count() - 1
+    *
+    * @return Fewest cycles taken by one call
+    */
+    uint32_t run(const uint8_t index) {
+        const auto body = reinterpret_cast<void (*)(void)>(pgm_read_ptr(&benchmarks[index].body));
+#ifndef BENCHMARK_LOOP_PROFILING
+        startCounter();
+#endif
+        const uint32_t overhead = timeCalls(empty);
+        const uint32_t elapsed = timeCalls(body);
+#ifndef BENCHMARK_LOOP_PROFILING
+        stopCounter();
+#endif
+        return (elapsed > overhead) ? elapsed - overhead : 0;
+    }
+
+#ifdef BENCHMARK_LOOP_PROFILING
+    /**
+    * @brief Marks the start of a pass of the scheduler loop; records the cycles taken by the last pass.
+    *
+    * @param mode   Operating mode (STATE) for the pass starting now
+    */
+    void loopMark(const uint8_t mode) {
+        const uint32_t now = cycles();
+        if (loopMode < MODE_COUNT) {
+            const uint32_t taken = now - loopStart;
+            loopMeans[loopMode] += taken - (loopMeans[loopMode] >> LOOP_MEAN_SHIFT);
+            if (taken > loopMaxima[loopMode]) {
+                loopMaxima[loopMode] = taken;
+            }
+        }
+        loopStart = now;
+        loopMode = mode;
+    }
+#endif
+
+    /**
+    * @brief Gets the running mean of the cycles taken by a pass of the scheduler loop.
+    *
+    * @param mode   Operating mode (STATE)
+    *
+    * @return Cycles; 0 if no pass has been made in the mode, or the loop is not profiled
+    */
+    uint32_t loopMean(const uint8_t mode) {
+#ifdef BENCHMARK_LOOP_PROFILING
+        return (mode < MODE_COUNT) ? loopMeans[mode] >> LOOP_MEAN_SHIFT : 0;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+    * @brief Gets the most cycles taken by any pass of the scheduler loop.
+    *
+    * @param mode   Operating mode (STATE)
+    *
+    * @return Cycles; 0 if no pass has been made in the mode, or the loop is not profiled
+    */
+    uint32_t loopMax(const uint8_t mode) {
+#ifdef BENCHMARK_LOOP_PROFILING
+        return (mode < MODE_COUNT) ? loopMaxima[mode] : 0;
+#else
+        return 0;
+#endif
+    }
+
+    /**
+    * @brief Clears the loop statistics.
+    *
+    */
+    void resetLoop(void) {
+#ifdef BENCHMARK_LOOP_PROFILING
+        memset(loopMeans, 0, sizeof(loopMeans));
+        memset(loopMaxima, 0, sizeof(loopMaxima));
+#endif
+    }
+
+    /**
+    * @brief Marks the end of a startup phase; only the first mark of each phase counts.
+    *
+    * @param phase   BOOT_PHASE
+    */
+    void bootMark(const uint8_t phase) {
+        if (phase < BOOT_PHASES && bootTimes[phase] == 0) {
+            bootTimes[phase] = micros();
+        }
+    }
+
+    /**
+    * @brief Gets the time a startup phase ended.
+    *
+    * @param phase   BOOT_PHASE
+    *
+    * @return Microseconds since the Arduino core started its timers; 0 if not reached
+    */
+    uint32_t bootTime(const uint8_t phase) {
+        return (phase < BOOT_PHASES) ? bootTimes[phase] : 0;
+    }
+
+    const __FlashStringHelper *bootPhaseName(const uint8_t phase) {
+        return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&bootPhaseNames[(phase < BOOT_PHASES) ? phase : 0]));
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      /**
+      * @brief Times BENCHMARK_CALLS calls of a benchmark body.
+      *
+      * @param body   Benchmark body
+      *
+      * @return Fewest cycles taken by any call, including the cost of timing it
+      */
+      uint32_t timeCalls(void (*body)(void)) {
+          auto fewest = UINT32_MAX;
+          for (auto n = uint8_t{0}; n < BENCHMARK_CALLS; n++) {
+              const uint32_t start = cycles();
+              body();
+              const uint32_t taken = cycles() - start;
+              if (taken < fewest) {
+                  fewest = taken;
+              }
+          }
+          return fewest;
+      }
+
+      /**
+      * @brief Starts Timer1 counting CPU cycles from 0.
+      *
+      */
+      void startCounter(void) {
+          ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+              TCCR1A = 0;
+              TCCR1B = bit(CS10);     // Normal mode, no prescaling
+              TCNT1 = 0;
+              TIFR1 = bit(TOV1);      // Clear any overflow left from the last run
+              overflows = 0;
+              TIMSK1 = bit(TOIE1);
+          }
+      }
+
+#ifndef BENCHMARK_LOOP_PROFILING
+      /**
+      * @brief Stops Timer1 and its overflow interrupt.
+      *
+      */
+      void stopCounter(void) {
+          ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+              TIMSK1 = 0;
+              TCCR1B = 0;
+          }
+      }
+#endif
+
+      void empty(void) {
+          sink = input16;
+      }
+
+      void nearest10(void) {
+          sink = MonitorTask::nearest10(input16);
+      }
+
+      void voltageString(void) {
+          sink = MonitorTask::generateVoltageString(input16)[0];
+      }
+
+      void multiply(void) {
+          sink = Fixed::multiply(inputFixed, inputFixed);
+      }
+
+      void invert(void) {
+          sink = Fixed::invert(inputFixed);
+      }
+
+      void correct(void) {
+          sink = Calibration::correct(MONITOR_CURRENT, input16);
+      }
+
+      void crc16(void) {
+          sink = Crc16::compute(crcData, sizeof(crcData));
+      }
+
+      void scaleCurrent(void) {
+          // As Adafruit_INA260::readCurrentInt16(), less the I2C transfer
+          const int16_t value = input16;
+          sink = value + (value >> 2);
+      }
+
+      void readFrame(void) {
+          int16_t frame[MONITOR_VALUES];
+          MonitorTask::readFrame(frame);
+          sink = frame[MONITOR_CURRENT];
+      }
+
+    }
+
+}
+
+/**
+* @brief Timer1 overflow interrupt handler; extends the cycle counter to 32 bits.
+*
+*/
+ISR(TIMER1_OVF_vect) {
+    Benchmark::overflows++;
+}
@@ -0,0 +1,64 @@
+#pragma once
+/**
+ * @file Benchmark.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for the on-device, cycle counting benchmarks.
+ *
+ */
+
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+#include <Arduino.h>
+
+// Calls timed by each benchmark run; the fastest is reported
+constexpr uint8_t BENCHMARK_CALLS = 100;
+
+// Uncomment to profile each pass of the scheduler loop (DIAG:LOOP?). This keeps Timer1 and its
+// overflow interrupt running all the time; otherwise Timer1 only runs during DIAG:BENCH?.
+// #define BENCHMARK_LOOP_PROFILING
+
+// Startup phases timed by Benchmark::bootMark(), in the order they end
+enum BOOT_PHASE : uint8_t {
+    BOOT_WATCHDOG,          // Reset cause recorded and watchdog running
+    BOOT_SENSORS,           // Sensors found and converting
+    BOOT_LCD,               // LCD initialized
+    BOOT_TASKS,             // Tasks set up (after the reset message, if shown)
+    BOOT_CALIBRATION,       // Calibration recalled
+    BOOT_ALERTS,            // Alert rules, event log and over-current trip set up
+    BOOT_FIRST_READING,     // First reading displayed, from the sensors' quick power-on configuration
+    BOOT_PRECISE_READING,   // First reading displayed from the averaged configuration
+    BOOT_PHASES,
+};
+
+namespace Benchmark {
+
+    void setup(void);
+    uint32_t cycles(void);
+
+    // Hot path benchmarks
+    uint8_t count(void);
+    const __FlashStringHelper *name(const uint8_t index);
+    uint32_t run(const uint8_t index);
+
+    // Scheduler loop profiling
+#ifdef BENCHMARK_LOOP_PROFILING
+    void loopMark(const uint8_t mode);
+#else
+    inline void loopMark(const uint8_t mode) {}
+#endif
+    uint32_t loopMean(const uint8_t mode);
+    uint32_t loopMax(const uint8_t mode);
+    void resetLoop(void);
+
+    // Startup profiling
+    void bootMark(const uint8_t phase);
+    uint32_t bootTime(const uint8_t phase);
+    const __FlashStringHelper *bootPhaseName(const uint8_t phase);
+
+}
+
+#endif
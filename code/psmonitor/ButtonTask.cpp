@@ -0,0 +1,212 @@
+/**
+ * @file ButtonTask.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a ButtonTask that turns button presses into click, double click and long press events.
+ *
+ * Implements a ButtonTask that watches the (hardware debounced, active low) mute/calibrate button.
+ * Button edges are captured and timestamped by a pin change interrupt, so presses are not missed
+ * while other tasks are running; the task later classifies the edges into events that are queued
+ * for the scheduler.
+ *
+ * To use the Button task:
+ *      - ButtonTask::setup() - setup the task and enable the pin change interrupt
+ *      - ButtonTask::update() - classify captured edges; call once each time through scheduler
+ *      - ButtonTask::getEvent() - call to retrieve the next queued BUTTON_EVENT (BUTTON_NONE if none)
+ *
+ * The button must be on one of digital pins 0 - 7 (port D, PCINT2). Apart from the interrupt
+ * handler, this code is intended to be run by a simple, non-preemptive round robin scheduler.
+ */
+
+// Include our own header file
+#include "ButtonTask.h"
+
+namespace ButtonTask {
+
+    /// States of the gesture recognition state machine
+    enum BUTTON_STATE : uint8_t {
+        BUTTON_IDLE,            // Released, nothing in progress
+        BUTTON_PRESSED,         // First press down
+        BUTTON_RELEASED,        // First press released; waiting to see if a second press follows
+        BUTTON_PRESSED_AGAIN,   // Second press down
+        BUTTON_HELD,            // Long press reported; waiting for release
+    };
+
+    // Edge capture; written by the interrupt handler, read by update()
+    struct edge {
+        uint16_t time;          // Low 16 bits of millis() at the edge
+        uint8_t level;          // Pin level after the edge
+    };
+    constexpr uint8_t EDGE_QUEUE_SIZE = 8;    // Power of two
+    volatile edge edges[EDGE_QUEUE_SIZE];
+    volatile uint8_t edgeHead = 0;
+    volatile uint8_t edgeLast = HIGH;
+    uint8_t edgeTail = 0;
+
+    // Events waiting for the scheduler
+    constexpr uint8_t EVENT_QUEUE_SIZE = 4;   // Power of two
+    uint8_t events[EVENT_QUEUE_SIZE];
+    uint8_t eventHead = 0;
+    uint8_t eventTail = 0;
+
+    volatile uint8_t *buttonPort = nullptr;
+    auto buttonMask = uint8_t{};
+    auto currentState = uint8_t{BUTTON_IDLE};
+    auto stateTime = uint16_t{};
+
+    /**
+    * @brief Configures the Button task and enables the pin change interrupt.
+    *
+    * @param pin       The digital pin that the button is connected to
+    */
+    void setup(const uint8_t pin) {
+        pinMode(pin, INPUT);
+        buttonPort = portInputRegister(digitalPinToPort(pin));
+        buttonMask = digitalPinToBitMask(pin);
+
+        // A button held down at powerup is ignored until released
+        edgeLast = (*buttonPort & buttonMask) ? HIGH : LOW;
+        currentState = (edgeLast == LOW) ? BUTTON_HELD : BUTTON_IDLE;
+
+        *digitalPinToPCMSK(pin) |= bit(digitalPinToPCMSKbit(pin));
+        *digitalPinToPCICR(pin) |= bit(digitalPinToPCICRbit(pin));
+    }
+
+    // Functions used only in this task
+    namespace
+    {
+
+      /**
+      * @brief Queues an event for the scheduler; drops the event if the queue is full.
+      *
+      * @param event   The BUTTON_EVENT to queue
+      */
+      void postEvent(const uint8_t event) {
+          const uint8_t next = (eventHead + 1) & (EVENT_QUEUE_SIZE - 1);
+          if (next != eventTail) {
+              events[eventHead] = event;
+              eventHead = next;
+          }
+      }
+
+      /**
+      * @brief Advances the gesture state machine for one captured edge.
+      *
+      * @param level   Pin level after the edge
+      * @param time    Low 16 bits of millis() at the edge
+      */
+      void processEdge(const uint8_t level, const uint16_t time) {
+          switch (currentState) {
+          case BUTTON_IDLE:
+              if (level == LOW) {
+                  currentState = BUTTON_PRESSED;
+                  stateTime = time;
+              }
+              break;
+          case BUTTON_PRESSED:
+              if (level == HIGH) {
+                  currentState = BUTTON_RELEASED;
+                  stateTime = time;
+              }
+              break;
+          case BUTTON_RELEASED:
+              if (level == LOW) {
+                  currentState = BUTTON_PRESSED_AGAIN;
+              }
+              break;
+          case BUTTON_PRESSED_AGAIN:
+              if (level == HIGH) {
+                  postEvent(BUTTON_DOUBLE_CLICK);
+                  currentState = BUTTON_IDLE;
+              }
+              break;
+          case BUTTON_HELD:
+          default:
+              if (level == HIGH) {
+                  currentState = BUTTON_IDLE;
+              }
+              break;
+          }
+      }
+
+    }
+
+    /**
+    * @brief Called each time through the scheduling loop to classify button edges.
+    *
+    * Processes edges captured by the interrupt handler in the order they occurred (using
+    * their timestamps) and then checks the long press and double click timeouts. Returns
+    * immediately when the button is idle and no edges are waiting.
+    */
+    void update(void) {
+        while (edgeTail != edgeHead) {
+            const uint8_t level = edges[edgeTail].level;
+            const uint16_t time = edges[edgeTail].time;
+            edgeTail = (edgeTail + 1) & (EDGE_QUEUE_SIZE - 1);
+
+            // A gesture timeout may have expired before this edge occurred
+            if (currentState == BUTTON_PRESSED && static_cast<uint16_t>(time - stateTime) >= BUTTON_LONG_PRESS_TIME) {
+                postEvent(BUTTON_LONG_PRESS);
+                currentState = BUTTON_HELD;
+            }
+            else if (currentState == BUTTON_RELEASED && static_cast<uint16_t>(time - stateTime) >= BUTTON_DOUBLE_CLICK_TIME) {
+                postEvent(BUTTON_CLICK);
+                currentState = BUTTON_IDLE;
+            }
+            processEdge(level, time);
+        }
+
+        if (currentState == BUTTON_IDLE || currentState == BUTTON_HELD) {
+            return;
+        }
+
+        const uint16_t elapsed = static_cast<uint16_t>(millis()) - stateTime;
+        if (currentState == BUTTON_PRESSED && elapsed >= BUTTON_LONG_PRESS_TIME) {
+            postEvent(BUTTON_LONG_PRESS);
+            currentState = BUTTON_HELD;
+        }
+        else if (currentState == BUTTON_RELEASED && elapsed >= BUTTON_DOUBLE_CLICK_TIME) {
+            postEvent(BUTTON_CLICK);
+            currentState = BUTTON_IDLE;
+        }
+    }
+
+    /**
+    * @brief Retrieves the next queued button event.
+    *
+    * @return The oldest queued BUTTON_EVENT, or BUTTON_NONE if no event is waiting
+    */
+    uint8_t getEvent(void) {
+        if (eventTail == eventHead) {
+            return BUTTON_NONE;
+        }
+        const uint8_t event = events[eventTail];
+        eventTail = (eventTail + 1) & (EVENT_QUEUE_SIZE - 1);
+        return event;
+    }
+
+}
+
+/**
+* @brief Pin change interrupt handler; timestamps and queues button edges.
+*
+* Only edges that change the button level are queued, and edges are dropped if the
+* queue is full (update() has not run for several presses).
+*/
+ISR(PCINT2_vect) {
+    using namespace ButtonTask;
+    const uint8_t level = (*buttonPort & buttonMask) ? HIGH : LOW;
+    if (level == edgeLast) {
+        return;
+    }
+    const uint8_t next = (edgeHead + 1) & (EDGE_QUEUE_SIZE - 1);
+    if (next == edgeTail) {
+        return;
+    }
+    edgeLast = level;
+    edges[edgeHead].time = static_cast<uint16_t>(millis());
+    edges[edgeHead].level = level;
+    edgeHead = next;
+}
@@ -0,0 +1,40 @@
+#pragma once
+/**
+ * @file ButtonTask.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for ButtonTask.
+ *
+ */
+
+#ifndef _BUTTONTASK_H
+#define _BUTTONTASK_H
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// Events recognised from the button
+enum BUTTON_EVENT : uint8_t {
+    BUTTON_NONE,            // No event pending
+    BUTTON_CLICK,           // Single short press
+    BUTTON_DOUBLE_CLICK,    // Two short presses in quick succession
+    BUTTON_LONG_PRESS,      // Press held for BUTTON_LONG_PRESS_TIME
+};
+
+// Gesture timing (all in milliseconds)
+enum BUTTON_TIMING : uint16_t {
+    BUTTON_DOUBLE_CLICK_TIME = 300,  // Maximum gap between the presses of a double click
+    BUTTON_LONG_PRESS_TIME = 800,    // Minimum hold time for a long press
+};
+
+namespace ButtonTask {
+
+    // Functions
+    void setup(const uint8_t pin);
+    void update(void);
+    uint8_t getEvent(void);
+};
+
+#endif
@@ -7,45 +7,141 @@
  * @brief Implements a BuzzerTask that manages buzzer activation, duration, and repetition.
  *
  * Implements a BuzzerTask that manages an active buzzer attached to an Arduino digital pin.
+ * Beep patterns (on time, off time and repeat count) are encoded in a table in program memory
+ * and sequenced by a 1 ms Timer2 compare interrupt, so beep timing does not depend on how
+ * often the scheduler runs. The timer interrupt is only enabled while a pattern is playing.
 
  * To use the Buzzer task:
- *      - BuzzerTask::setup() - setup the task
- *      - BuzzerTask::update() - run the buzzer process; call once each time through scheduler
- *      - BuzzerTask::beep() - call each time a sequence of beeps are desired
+ *      - BuzzerTask::setup() - setup the task and Timer2
+ *      - BuzzerTask::play() - call each time a pattern of beeps is desired
  *      - BuzzerTask::mute() - call to disable buzzer sounds, but otherwise don't change buzzer function
  *      - BuzzerTask::unmute() - call to restore buzzer sounds, but otherwise don't change buzzer function
  *      - BuzzerTask::toggleMute() - call to turn toggle the state of buzzer muting
+ *      - BuzzerTask::muted() - call to get the state of buzzer muting
  *
- * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
- * is responsible for relinquishing control; this code is *not threadsafe* and must not be
- * interrupted.
+ * Timer2 is reserved for this task (so tone() must not be used).
  */
 
+// Include standard headers as needed
+#include <util/atomic.h>
+
 // Include our own header file
 #include "BuzzerTask.h"
 
 namespace BuzzerTask {
 
+    /// Encoded beep pattern; times are in units of BEEP_UNIT milliseconds
+    struct beep_pattern {
+        uint8_t on;        // Time the buzzer sounds for each beep
+        uint8_t off;       // Time between beeps (and before the next queued pattern)
+        uint8_t count;     // Number of beeps
+        uint8_t priority;  // BEEP_PRIORITY of the pattern
+    };
+
+    // Pattern table, indexed by BEEP_PATTERN
+    const beep_pattern patterns[] PROGMEM = {
+        {BEEP_SHORT / BEEP_UNIT,  BEEP_SPACING / BEEP_UNIT, 1, PRIORITY_INFO},    // PATTERN_READY
+        {BEEP_MEDIUM / BEEP_UNIT, BEEP_SPACING / BEEP_UNIT, 2, PRIORITY_INFO},    // PATTERN_CALIBRATE
+        {BEEP_LONG / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 3, PRIORITY_ALARM},   // PATTERN_FAULT
+        {BEEP_BLIP / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 1, PRIORITY_INFO},    // PATTERN_BUTTON
+        {BEEP_BLIP / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 2, PRIORITY_INFO},    // PATTERN_MUTE
+        {BEEP_BLIP / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 3, PRIORITY_INFO},    // PATTERN_UNMUTE
+        {BEEP_BLIP / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 1, PRIORITY_ALARM},   // PATTERN_OVER_RANGE
+        {BEEP_BLIP / BEEP_UNIT,   BEEP_SPACING / BEEP_UNIT, 3, PRIORITY_INFO},    // PATTERN_CALIBRATED
+    };
+    static_assert(sizeof(patterns) / sizeof(patterns[0]) == PATTERN_CALIBRATED + 1,
+                  "Pattern table must have an entry for every BEEP_PATTERN");
+
     auto muteMode = bool{false};
 
-    auto buzzerPin = uint8_t{};
+    volatile uint8_t *buzzerPort = nullptr;
+    auto buzzerMask = uint8_t{};
     auto buzzerOn = uint8_t{};
-    auto buzzerOff = uint8_t{};
 
-    struct {
-        uint16_t duration = 0;
-        uint16_t count = 0;
-        bool doingBeepSpacing = false;
-    } beepData;
+    // Pattern request queue, highest priority first; shared with the timer interrupt handler
+    constexpr uint8_t QUEUE_SIZE = 4;
+    constexpr uint8_t NO_PATTERN = 0xFF;
+    volatile uint8_t queue[QUEUE_SIZE];
+    volatile uint8_t queued = 0;         // Number of requests waiting
+    volatile uint8_t playing = NO_PATTERN;
+
+    // Sequencer state; shared with the timer interrupt handler
+    volatile uint16_t remaining = 0;    // Milliseconds left in the current on or off phase
+    volatile uint8_t beepsLeft = 0;     // Beeps left, including the one sounding
+    volatile bool sounding = false;     // Buzzer is on
+    volatile uint8_t onTime = 0;        // Pattern on time (BEEP_UNIT)
+    volatile uint8_t offTime = 0;       // Pattern off time (BEEP_UNIT)
+
+    /**
+    * @brief Turns the buzzer on or off; safe to call from the interrupt handler.
+    *
+    * @param on   True to sound the buzzer
+    */
+    inline void drive(const bool on) {
+        if (on == (buzzerOn == HIGH)) {
+            *buzzerPort |= buzzerMask;
+        }
+        else {
+            *buzzerPort &= ~buzzerMask;
+        }
+    }
+
+    /**
+    * @brief Returns the priority of a pattern.
+    *
+    * @param pattern   The BEEP_PATTERN
+    */
+    inline uint8_t priority(const uint8_t pattern) {
+        return pgm_read_byte(&patterns[pattern].priority);
+    }
+
+    /**
+    * @brief Starts playing a pattern; called with interrupts disabled.
+    *
+    * @param pattern   The BEEP_PATTERN to play
+    */
+    void start(const uint8_t pattern) {
+        playing = pattern;
+        onTime = pgm_read_byte(&patterns[pattern].on);
+        offTime = pgm_read_byte(&patterns[pattern].off);
+        beepsLeft = pgm_read_byte(&patterns[pattern].count);
+        remaining = static_cast<uint16_t>(onTime) * BEEP_UNIT;
+        sounding = true;
+        drive(true);
+    }
 
-    // Task timing (all in milliseconds)
-    constexpr uint32_t rolloverThreshold = static_cast<uint32_t>(100ul) * BEEP_LONG;
-    auto currentTime = uint32_t{};
-    auto targetTime = uint32_t{0};
+    /**
+    * @brief Inserts a request into the queue; called with interrupts disabled.
+    *
+    * The request goes behind all requests of higher priority and, unless @p ahead is set,
+    * also behind those of equal priority. When the queue is full the lowest priority request
+    * (the last one) is discarded to make room, or the new request is dropped if it would be last.
+    *
+    * @param pattern   The BEEP_PATTERN to queue
+    * @param ahead     Queue ahead of requests of equal priority (used to resume a pre-empted pattern)
+    */
+    void enqueue(const uint8_t pattern, const bool ahead) {
+        const uint8_t level = priority(pattern);
+        auto slot = uint8_t{0};
+        while (slot < queued && (priority(queue[slot]) > level || (!ahead && priority(queue[slot]) == level))) {
+            slot++;
+        }
+        if (slot >= QUEUE_SIZE) {
+            return;
+        }
+        auto last = (queued < QUEUE_SIZE) ? queued++ : static_cast<uint8_t>(QUEUE_SIZE - 1);
+        for (; last > slot; last--) {
+            queue[last] = queue[last - 1];
+        }
+        queue[slot] = pattern;
+    }
 
     /**
     * @brief Configures the Buzzer task to the Arduino hardware in use.
     *
+    * Sets up Timer2 in CTC mode for a 1 ms compare interrupt (16 MHz / 64 / 250); the
+    * interrupt itself is only enabled while a pattern plays.
+    *
     * @param pin       The digital pin that the buzzer is connected to
     * @param on_value  The value (HIGH or LOW) that turns on the buzzer
     * @param off_value The value (HIGH or LOW) that turns off the buzzer
@@ -54,29 +150,51 @@ namespace BuzzerTask {
                const uint8_t on_value,
                const uint8_t off_value) {
 
-        buzzerPin = pin;
+        buzzerPort = portOutputRegister(digitalPinToPort(pin));
+        buzzerMask = digitalPinToBitMask(pin);
         buzzerOn = on_value;
-        buzzerOff = off_value;
+        digitalWrite(pin, off_value);
+
+        TCCR2A = bit(WGM21);
+        TCCR2B = bit(CS22);
+        OCR2A = (F_CPU / 64 / 1000) - 1;
     }
 
     /**
-    * @brief Sounds the buzzer for a selectable time one or more times.
+    * @brief Requests one of the predefined beep patterns.
+    *
+    * Plays the pattern at once if the buzzer is idle or the pattern pre-empts the one
+    * playing; otherwise queues it. Requests for a pattern already playing or queued are
+    * ignored.
     *
-    * @param duration  The time in milliseconds to sound the buzzer
-    * @param count     The number of times to sound the buzzer
+    * @param pattern   The BEEP_PATTERN to play
     */
-    void beep(const uint32_t duration, const uint32_t count) {
-        if (count == 0) {
+    void play(const uint8_t pattern) {
+        if (muteMode || pattern > PATTERN_CALIBRATED) {
             return;
         }
-        if (!muteMode) {
-            currentTime = millis();
-            digitalWrite(buzzerPin, buzzerOn);
-            beepData.duration = duration;
-            beepData.count = count;
-            beepData.doingBeepSpacing = false;
-            targetTime = currentTime + duration;
-            beepData.count--;
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            if (pattern == playing) {
+                return;
+            }
+            for (auto slot = uint8_t{0}; slot < queued; slot++) {
+                if (queue[slot] == pattern) {
+                    return;
+                }
+            }
+
+            if (playing == NO_PATTERN && queued == 0) {
+                start(pattern);
+                TCNT2 = 0;
+                TIMSK2 |= bit(OCIE2A);
+            }
+            else if (playing != NO_PATTERN && priority(pattern) > priority(playing)) {
+                enqueue(playing, true);
+                start(pattern);
+            }
+            else {
+                enqueue(pattern, false);
+            }
         }
     }
 
@@ -85,7 +203,10 @@ namespace BuzzerTask {
     *
     */
     void mute(void) {
-        beep(BEEP_BLIP, 2);
+        ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+            queued = 0;
+        }
+        play(PATTERN_MUTE);
         muteMode = true;
     }
 
@@ -95,7 +216,7 @@ namespace BuzzerTask {
     */
     void unmute(void) {
         muteMode = false;
-        beep(BEEP_BLIP, 3);
+        play(PATTERN_UNMUTE);
     }
 
     /**
@@ -112,39 +233,54 @@ namespace BuzzerTask {
     }
 
     /**
-    * @brief Called each time through the scheduling loop to manage the buzzer.
+    * @brief Gets the mute state of the buzzer.
     *
-    * Implements the BuzzerTask. Runs whenever the scheduler transfers control to the
-    * BuzzerTask and determines if it is time to run; if not time to run, immediately
-    * relinquishes control back to the scheduler.
+    * @return True if the buzzer is muted
     */
-    void update(void) {
-        currentTime = millis();
-        
-        // Handle timer register rollover.
-        // The problem occurs when the current time rolls over with the target
-        // time near rollover; this results in the task stalling until the current
-        // time catches up with the target time (rare, but possible). Since
-        // the greatest difference between the targetTime and currentTime should be
-        // on the order of the longest buzzer time, if it is much greater (e.g. 100X) then
-        // that indicates a rollover has occurred.
-        if ((currentTime >= targetTime) || (targetTime - currentTime) > rolloverThreshold) {
-            if (beepData.count == 0) {
-                digitalWrite(buzzerPin, buzzerOff);
-                return;
-            }
-            // Note: to get here beepData.count must be > 0.
-            if (!beepData.doingBeepSpacing) {
-                digitalWrite(buzzerPin, buzzerOff);
-                beepData.doingBeepSpacing = true;
-                targetTime += BEEP_SPACING;
-            }
-            else {
-                digitalWrite(buzzerPin, buzzerOn);
-                beepData.doingBeepSpacing = false;
-                targetTime += beepData.duration;
-                beepData.count--;
+    bool muted(void) {
+        return muteMode;
+    }
+}
+
+/**
+* @brief Timer2 compare interrupt handler; steps the beep pattern sequencer once per millisecond.
+*
+* Counts down the current on or off phase and switches phase when it expires. After the last
+* beep of a pattern, starts the next queued pattern (following the off time), or disables
+* itself if nothing is queued.
+*/
+ISR(TIMER2_COMPA_vect) {
+    using namespace BuzzerTask;
+    if (--remaining != 0) {
+        return;
+    }
+    if (sounding) {
+        drive(false);
+        sounding = false;
+        remaining = static_cast<uint16_t>(offTime) * BEEP_UNIT;
+        if (--beepsLeft == 0) {
+            playing = NO_PATTERN;
+            if (queued == 0) {
+                TIMSK2 &= ~bit(OCIE2A);
             }
         }
     }
-}
\ No newline at end of file
+    else if (beepsLeft == 0) {
+        // Gap after a pattern has finished; the queue may have been flushed meanwhile
+        if (queued == 0) {
+            TIMSK2 &= ~bit(OCIE2A);
+            return;
+        }
+        const uint8_t next = queue[0];
+        queued--;
+        for (auto slot = uint8_t{0}; slot < queued; slot++) {
+            queue[slot] = queue[slot + 1];
+        }
+        start(next);
+    }
+    else {
+        drive(true);
+        sounding = true;
+        remaining = static_cast<uint16_t>(onTime) * BEEP_UNIT;
+    }
+}
@@ -15,8 +15,9 @@
 // Include standard headers as needed
 #include <Arduino.h>
 
-// Some predefined buzzer durations
-enum BEEP : uint32_t {
+// Some predefined buzzer durations (milliseconds; multiples of BEEP_UNIT)
+enum BEEP : uint16_t {
+    BEEP_UNIT = 10,
     BEEP_BLIP = 50,
     BEEP_SHORT = 100,
     BEEP_MEDIUM = 250,
@@ -24,17 +25,35 @@ enum BEEP : uint32_t {
     BEEP_SPACING = 50
 };
 
+// Predefined beep patterns; indexes into the pattern table
+enum BEEP_PATTERN : uint8_t {
+    PATTERN_READY,          // Powered up in normal mode
+    PATTERN_CALIBRATE,      // Powered up in calibrate mode
+    PATTERN_FAULT,          // Sensor communication fault
+    PATTERN_BUTTON,         // Button acknowledged
+    PATTERN_MUTE,           // Alerts muted
+    PATTERN_UNMUTE,         // Alerts unmuted
+    PATTERN_OVER_RANGE,     // Output over specification
+    PATTERN_CALIBRATED,     // Calibration finished
+};
+
+// Beep priorities; a higher priority pattern pre-empts a lower priority one
+enum BEEP_PRIORITY : uint8_t {
+    PRIORITY_INFO = 0,      // Confirmations and status
+    PRIORITY_ALARM = 1,     // Faults and over specification alerts
+};
+
 namespace BuzzerTask {
 
     // Functions
     void setup(const uint8_t pin,
                const uint8_t on_value,
                const uint8_t off_value);
-    void beep(const uint32_t duration, const uint32_t count);
+    void play(const uint8_t pattern);
     void mute(void);
     void unmute(void);
     void toggleMute(void);
-    void update(void);
+    bool muted(void);
 };
 
-#endif
\ No newline at end of file
+#endif
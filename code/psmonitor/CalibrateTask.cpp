@@ -6,15 +6,21 @@
  *
  * @brief Implements a CalibrateTask that determines gain and offset errors for all voltages and currents.
  *
- * Implements a CalibrateTask that measures sets of raw values from the ADCs of two INA260
- * voltage/current sensors and computes gain and offset corrections for all measurements.
+ * Implements a CalibrateTask that measures sets of raw values from the ADCs of the INA260
+ * voltage/current sensors (one per output) and computes gain and offset corrections for all measurements.
  * Corrections are written to EEPROM where they can be used by other tasks.
  *
+ * Each calibration point is the mean of a number of sets of raw values, one per sensor
+ * conversion. The mean and variance are accumulated as the sets are read; if any output
+ * varied by more than CALIBRATE_MAX_DEVIATION counts (standard deviation), the supply was
+ * still settling, so the point is rejected and the technician is prompted to take it again.
+ *
  * To use the Calibrate task:
  *      - CalibrateTask::setup() - setup the task
  *      - CalibrateTask::update() - run the calibration process; call once each time through scheduler.
  *        Waits for button presses between steps in the process
  *      - CalibrateTask::buttonPress() - call to advance to the next step in the process
+ *      - CalibrateTask::setSampleCount() / CalibrateTask::getSampleCount() - sets of raw values per point
  *      - CalibrateTask::finished() - call to determine if calibration process is finished.
  *        Scheduling of the Calibrate task should stop when this flag becomes True
  *
@@ -37,9 +43,11 @@
 // Include our own header file and supporting utilities
 #include "CalibrateTask.h"
 #include "Calibration.h"
+#include "Glyphs.h"
 
 // Include headers for other tasks that are used during calibration
 #include "MonitorTask.h"
+#include "Readings.h"
 
 // External storage shared between tasks
 #include "globals.h"
@@ -66,6 +74,9 @@ namespace CalibrateTask {
 
       char* generateVoltageString(const int16_t value);
       void updateCalibrationData(const int16_t measurement_type, const int16_t position, const int16_t actual);
+      bool capture(const int16_t measurement_type);
+      bool collect(void);
+      bool settled(void);
 
     }
 
@@ -76,18 +87,6 @@ namespace CalibrateTask {
     LiquidCrystal *lcd = nullptr;
     // int16_t rawPoints[4];     // (x1, y1), (x2, y2)
 
-    /// Create required plus/minus special character for lcd
-    uint8_t chr1[8] = { 
-        B00100,
-        B00100,
-        B11111,
-        B00100,
-        B00100,
-        B00000,
-        B11111,
-        B00000
-    };  
-
     // Define the prompt strings used, store in program memory
     const char promptIntro[] PROGMEM = "  Calibration";
     const char promptPushButton[] PROGMEM = "  Push Button";
@@ -100,9 +99,30 @@ namespace CalibrateTask {
     constexpr int16_t CALIBRATE_LOW_I = LIMIT_MAX_CURRENT / 10;
     constexpr int16_t CALIBRATE_HIGH_I = (LIMIT_MAX_CURRENT / 10) * 9;
 
+    // Sets of raw values averaged for each calibration point, and the largest standard deviation
+    // (in raw counts) accepted as settled
+    constexpr uint8_t CALIBRATE_MIN_SAMPLES = 2;
+    constexpr uint8_t CALIBRATE_MAX_SAMPLES = 64;
+    constexpr uint16_t CALIBRATE_MAX_DEVIATION = 4;
+    auto sampleCount = uint8_t{16};
+
+    // Calibration point capture. Values are accumulated as deviations from the first set,
+    // which keeps the sums small; sums of squares saturate (and then fail the settled check).
+    const char promptMeasuring[] PROGMEM = "  Measuring...";
+    const char promptUnsettled[] PROGMEM = "Not settled";
+    auto sampling = bool{false};
+    auto captured = bool{false};
+    auto captureType = int16_t{MONITOR_VOLTAGE};
+    auto samplesTaken = uint8_t{0};
+    auto sampleTarget = uint32_t{};
+    int16_t first[MONITOR_OUTPUTS];         // First set, indexed by output
+    int32_t sums[MONITOR_OUTPUTS];          // Sum of deviations from the first set
+    uint32_t squares[MONITOR_OUTPUTS];      // Sum of squared deviations from the first set
+    int16_t means[MONITOR_OUTPUTS];         // Means of the point once captured
+
     // Raw calibration data sent to Calibration utility
-    int16_t actuals[8] = {};     // Actual values that *should* have been set by technician
-    int16_t measured[8] = {};    // Raw measured values corresponding to actuals
+    int16_t actuals[MEASURED_SLOTS * MONITOR_OUTPUTS] = {};     // Actual values that *should* have been set by technician
+    int16_t measured[MEASURED_SLOTS * MONITOR_OUTPUTS] = {};    // Raw measured values corresponding to actuals
 
     /**
     * @brief Configures the calibrate task LCD display and loads special characters into display.
@@ -110,8 +130,10 @@ namespace CalibrateTask {
     * @param display   Pointer to the LCD display object
     */
     void setup(LiquidCrystal *display) {
+        lcd = display;
+
         // Load required special character into lcd 
-        display->createChar(1, chr1);
+        Glyphs::load(1, GLYPH_PLUS_MINUS);
     }
 
     /**
@@ -131,6 +153,25 @@ namespace CalibrateTask {
         return finishedFlag;
     }
 
+    /**
+    * @brief Sets the number of sets of raw values averaged for each calibration point.
+    *
+    * @param count   Number of sets, CALIBRATE_MIN_SAMPLES - CALIBRATE_MAX_SAMPLES
+    *
+    * @return False if count is out of range
+    */
+    bool setSampleCount(const uint8_t count) {
+        if (count < CALIBRATE_MIN_SAMPLES || count > CALIBRATE_MAX_SAMPLES) {
+            return false;
+        }
+        sampleCount = count;
+        return true;
+    }
+
+    uint8_t getSampleCount(void) {
+        return sampleCount;
+    }
+
     /**
     * @brief Called each time through the scheduling loop to implement calibration.
     *
@@ -139,6 +180,23 @@ namespace CalibrateTask {
     * relinquishes control back to the scheduler.
     */
     void update(void) {
+        // Collect the sets for a calibration point, then run the step that asked for them
+        if (!finishedFlag && sampling) {
+            if (!collect()) {
+                return;
+            }
+            sampling = false;
+            if (!settled()) {
+                lcd->clear();
+                lcd->print((const __FlashStringHelper *)promptUnsettled);
+                lcd->setCursor(0, 1);
+                lcd->print((const __FlashStringHelper *)promptPushButton);
+                return;     // A button push repeats the step
+            }
+            captured = true;
+            executeStep = true;
+        }
+
         if (!finishedFlag && executeStep) {
             executeStep = false;    // Wait for a button push to run next step
             lcd->clear();
@@ -163,7 +221,9 @@ namespace CalibrateTask {
                 break;
 
             case CALIBRATE_READ_LOW_V_PROMPT_HIGH_V:
-                MonitorTask::getRawValues();
+                if (!capture(MONITOR_VOLTAGE)) {
+                    break;
+                }
                 updateCalibrationData(MONITOR_VOLTAGE, MEASURED_LOW_V, CALIBRATE_LOW_V);
                 lcd->print((const __FlashStringHelper *)promptVolts);
                 lcd->write(1);
@@ -174,7 +234,9 @@ namespace CalibrateTask {
                 break;
 
             case CALIBRATE_READ_HIGH_V_PROMPT_LOW_I:
-                MonitorTask::getRawValues();
+                if (!capture(MONITOR_VOLTAGE)) {
+                    break;
+                }
                 updateCalibrationData(MONITOR_VOLTAGE, MEASURED_HIGH_V, CALIBRATE_HIGH_V);
                 lcd->print((const __FlashStringHelper *)promptCurrent);
                 (void) sprintf(string_buf, "% 5d", CALIBRATE_LOW_I);
@@ -186,7 +248,9 @@ namespace CalibrateTask {
                 break;
 
             case CALIBRATE_READ_LOW_I_PROMPT_HIGH_I:
-                MonitorTask::getRawValues();
+                if (!capture(MONITOR_CURRENT)) {
+                    break;
+                }
                 updateCalibrationData(MONITOR_CURRENT, MEASURED_LOW_I, CALIBRATE_LOW_I);
                 lcd->print((const __FlashStringHelper *)promptCurrent);
                 (void) sprintf(string_buf, "% 5d", CALIBRATE_HIGH_I);
@@ -199,7 +263,9 @@ namespace CalibrateTask {
 
             case CALIBRATE_READ_HIGH_I_FINISH:
             default:
-                MonitorTask::getRawValues();
+                if (!capture(MONITOR_CURRENT)) {
+                    break;
+                }
                 updateCalibrationData(MONITOR_CURRENT, MEASURED_HIGH_I, CALIBRATE_HIGH_I);
                 Calibration::update(actuals, measured);
                 finishedFlag = true;
@@ -235,6 +301,84 @@ namespace CalibrateTask {
           return string_buf;
       }
 
+      /**
+      * @brief Captures a calibration point; starts collecting sets of raw values if not yet captured.
+      *
+      * @param measurement_type   Which parameter, voltage or current, to measure
+      *
+      * @return True if the point has been captured; its means are in means[]
+      */
+      bool capture(const int16_t measurement_type) {
+          if (captured) {
+              captured = false;
+              return true;
+          }
+          captureType = measurement_type;
+          samplesTaken = 0;
+          sampleTarget = micros();
+          sampling = true;
+          lcd->print((const __FlashStringHelper *)promptMeasuring);
+          return false;
+      }
+
+      /**
+      * @brief Reads the next set of raw values for a calibration point, once the sensors have converted it.
+      *
+      * @return True once all sets for the point have been read
+      */
+      bool collect(void) {
+          const uint32_t now = micros();
+          if (static_cast<int32_t>(now - sampleTarget) < 0) {
+              return false;
+          }
+          sampleTarget = now + MonitorTask::getSamplePeriod();
+
+          MonitorTask::getRawValues();
+          int16_t raw[MONITOR_VALUES];
+          (void) Readings::read(raw);
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              const int16_t value = raw[captureType + output];
+              if (samplesTaken == 0) {
+                  first[output] = value;
+                  sums[output] = 0;
+                  squares[output] = 0;
+                  continue;
+              }
+              const int32_t deviation = static_cast<int32_t>(value) - first[output];
+              const uint32_t magnitude = (deviation < 0) ? -deviation : deviation;
+              const uint32_t square = magnitude * magnitude;
+              sums[output] += deviation;
+              squares[output] = (square <= UINT32_MAX - squares[output]) ? squares[output] + square : UINT32_MAX;
+          }
+          return ++samplesTaken >= sampleCount;
+      }
+
+      /**
+      * @brief Checks that the supply was steady while a calibration point was collected.
+      *
+      * Leaves the mean of each value in means[].
+      *
+      * @return False if the variance of any value exceeds CALIBRATE_MAX_DEVIATION squared
+      */
+      bool settled(void) {
+          auto steady = true;
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              // n * variance = sum of squares - sum * mean; with the mean truncated toward zero,
+              // sum * mean never exceeds the sum of squares
+              const uint32_t sumMagnitude = (sums[output] < 0) ? -sums[output] : sums[output];
+              const uint32_t meanMagnitude = sumMagnitude / samplesTaken;
+              const uint32_t spread = squares[output] - sumMagnitude * meanMagnitude;
+              if (squares[output] == UINT32_MAX ||
+                  spread > static_cast<uint32_t>(CALIBRATE_MAX_DEVIATION * CALIBRATE_MAX_DEVIATION) * (samplesTaken - 1)) {
+                  steady = false;
+              }
+              // The mean itself is rounded to the nearest unit, halves away from zero
+              const int32_t rounded = (sumMagnitude + samplesTaken / 2) / samplesTaken;
+              means[output] = first[output] + static_cast<int16_t>((sums[output] < 0) ? -rounded : rounded);
+          }
+          return steady;
+      }
+
       /**
       * @brief Populates subset of calibration data array.
       *
@@ -243,13 +387,14 @@ namespace CalibrateTask {
       *
       * @param measurement_type   Which parameter, voltage or current, was measured
       * @param position   Which voltage or current was measured (high or low)
-      * @param actual     Voltage or current that technician *should* have set for this step
+      * @param actual     Voltage or current that technician *should* have set for this step,
+      *                   on every output (magnitude)
       */
       void updateCalibrationData(const int measurement_type, const int position, const int16_t actual) {
-          measured[MEASURED_POS + position] = readings[measurement_type + MONITOR_POS];
-          measured[MEASURED_NEG + position] = readings[measurement_type + MONITOR_NEG];
-          actuals[MEASURED_POS + position] = actual;
-          actuals[MEASURED_NEG + position] = actual;
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              measured[output * MEASURED_SLOTS + position] = means[output];
+              actuals[output * MEASURED_SLOTS + position] = actual;
+          }
       }
 
     }
@@ -20,6 +20,8 @@ namespace CalibrateTask {
     void setup(LiquidCrystal *display);
     void buttonPress(void);
     bool finished(void);
+    bool setSampleCount(const uint8_t count);
+    uint8_t getSampleCount(void);
     void update(void);
 
 }
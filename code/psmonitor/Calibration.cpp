@@ -10,6 +10,15 @@
  * a CRC for the data to ensure that unwritten or corrupted calibration data are detected and
  * rejected. 
  *
+ * Calibration data are kept as a number of named profiles (one per supply or sensor board
+ * the monitor is used with), with a small directory recording which profile is active.
+ * Selecting a profile loads its correction constants in one step. Each profile holds the
+ * corrections of every output, so as many profiles are kept as fit their EEPROM space (see
+ * CALIBRATION_PROFILES). Each profile carries a format version; the single record kept before
+ * profiles were introduced is migrated into profile 0 the first time the firmware finds no
+ * directory, and version 1 profiles (two outputs, corrections indexed as readings) are
+ * converted the first time the firmware finds a version 1 directory.
+ *
  * If calibration not performed or data corrupt, the following defaults are used for
  * all channels:
  *      - Voltage Offset: 0
@@ -21,7 +30,7 @@
 // Standard header files
 #include <Arduino.h>
 #include <EEPROM.h>
-#include <CRC.h>
+#include <stddef.h>
 
 // Include our own header file
 #include "Calibration.h"
@@ -38,36 +47,119 @@
 // Fixed point arithmetic specific to this project
 #include "Fixed.h"
 
-// Array of integers holding a set of current and voltage measurements
-extern int16_t readings[4];
+// CRC used to validate EEPROM data, and deferred writing
+#include "Crc16.h"
+#include "EepromWriter.h"
 
 
 namespace Calibration {
 
-    // A common struct for calibration data; change once and it changes eerywhere.
+    // Calibration data as stored before profiles were introduced (at CALIBRATION_DATA_ADDRESS);
+    // corrections of two outputs, indexed as their readings (V+, V-, I+, I-)
     struct cal_data {
         int16_t offsets[4];    // Array of voltage and current offset corrections
         fixed gains[4];        // Fixed point array of voltage and current gain correction factors
         uint16_t crc;          // CRC value validating calibration data
     };
 
-    // EEPROM struct containing calibration data
-    cal_data eeprom_data;
+    // Calibration profile of version 1 firmware; corrections indexed as in cal_data
+    struct cal_profile_v1 {
+        uint8_t version;                    // 1
+        char name[CALIBRATION_NAME_LENGTH]; // Profile name; padded with nuls, not terminated if full length
+        int16_t offsets[4];                 // Array of voltage and current offset corrections
+        fixed gains[4];                     // Fixed point array of voltage and current gain correction factors
+        uint16_t crc;                       // CRC value validating the profile
+    };
+
+    // Corrections of one output, indexed by reading group (MONITOR_SELECT_GROUP / MONITOR_OUTPUTS)
+    struct cal_output {
+        int16_t offsets[2];    // Voltage and current offset corrections
+        fixed gains[2];        // Fixed point voltage and current gain correction factors
+    };
+
+    // A calibration profile; change once and it changes everywhere.
+    struct cal_profile {
+        uint8_t version;                        // CALIBRATION_PROFILE_VERSION
+        char name[CALIBRATION_NAME_LENGTH];     // Profile name; padded with nuls, not terminated if full length
+        cal_output outputs[MONITOR_OUTPUTS];    // Corrections of each output
+        uint16_t crc;                           // CRC value validating the profile
+    };
+
+    // Directory of profiles
+    struct cal_directory {
+        uint8_t version;       // CALIBRATION_PROFILE_VERSION
+        uint8_t active;        // Profile in use
+        uint16_t crc;          // CRC value validating the directory
+    };
+
+    // Format of profiles and directory; a change to either must bump this and migrate
+    constexpr uint8_t CALIBRATION_PROFILE_VERSION = 2;
 
-    // Default calibration data
-    cal_data calibration_defaults = {
-        {0, 0, 0, 0},
-        {Fixed::int2fixed(1), Fixed::int2fixed(1), Fixed::int2fixed(1), Fixed::int2fixed(1)},
-        calcCRC16(reinterpret_cast<uint8_t*>(&calibration_defaults), sizeof(calibration_defaults) - sizeof(calibration_defaults.crc))
+    // Number of bytes of each record covered by its CRC
+    constexpr uint16_t crc_length = offsetof(cal_data, crc);
+    static_assert(crc_length == sizeof(cal_data::offsets) + sizeof(cal_data::gains),
+                  "cal_data must not contain padding ahead of the CRC");
+    constexpr uint16_t profile_v1_crc_length = offsetof(cal_profile_v1, crc);
+    static_assert(profile_v1_crc_length == 1 + CALIBRATION_NAME_LENGTH + crc_length,
+                  "cal_profile_v1 must not contain padding ahead of the CRC");
+    constexpr uint16_t profile_crc_length = offsetof(cal_profile, crc);
+    static_assert(profile_crc_length + sizeof(uint16_t) == CALIBRATION_PROFILE_SIZE,
+                  "cal_profile must not contain padding ahead of the CRC");
+    constexpr uint16_t directory_crc_length = offsetof(cal_directory, crc);
+
+    // EEPROM space reserved for profiles; version 1 firmware kept 4 profiles of 34 bytes there
+    static_assert(CALIBRATION_PROFILES > 0 &&
+                  CALIBRATION_PROFILES * sizeof(cal_profile) <= EEPROM_CALIBRATION_PROFILES_END - EEPROM_CALIBRATION_PROFILES,
+                  "Calibration profiles must fit in their EEPROM space");
+    constexpr uint8_t CALIBRATION_PROFILES_V1 = 4;
+    constexpr uint16_t CALIBRATION_PROFILE_SIZE_V1 = 34;
+
+    // Default calibration values: zero offset and unity gain
+    constexpr int16_t default_offset = 0;
+    constexpr fixed default_gain = Fixed::fixed_one;
+
+    static_assert(Fixed::fixed2int(default_gain) == 1, "Default gain must be unity");
+    static_assert(Fixed::multiply(default_gain, Fixed::int2fixed(LIMIT_MAX_VOLTAGE / 10)) == Fixed::int2fixed(LIMIT_MAX_VOLTAGE / 10),
+                  "Default gain must leave values unchanged");
+    static_assert(Fixed::invert(default_gain) == default_gain, "Default gain must be invertible");
+
+    // Name of the default profile, and of the profile migrated from the old single record
+    const char default_name[CALIBRATION_NAME_LENGTH] PROGMEM = {'D', 'E', 'F', 'A', 'U', 'L', 'T'};
+
+    // Default corrections of an output; a constant record kept in program memory
+    const cal_output output_defaults PROGMEM = {
+        {default_offset, default_offset},
+        {default_gain, default_gain}
     };
 
-    // Points to the working copy of current calibration data
-    cal_data *calibration_data = &calibration_defaults;
+    // Working copy of current calibration data; loaded from EEPROM or defaults
+    cal_profile calibration_data;
+
+    // Working copy of the directory
+    cal_directory directory;
 
 
     // Manage recall of persistent calibration data
     auto data_recalled = bool{false};
     auto data_valid = bool{false};
+    auto data_dirty = bool{true};    // EEPROM holds data not yet in the working copy
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      int16_t profileAddress(const uint8_t index);
+      bool readProfile(const uint8_t index, cal_profile &profile);
+      void stampProfile(cal_profile &profile);
+      void writeProfile(const uint8_t index, cal_profile &profile);
+      void writeDirectory(void);
+      void defaults(cal_profile &profile);
+      void convert(const int16_t offsets[], const fixed gains[], cal_profile &profile);
+      void migrate(const uint8_t from);
+      void migrateLegacy(void);
+      void migrateProfiles(void);
+
+    }
 
 
     /**
@@ -84,23 +176,37 @@ namespace Calibration {
     /**
     * @brief Retrieves calibration values from EEPROM and populates calibration data arrays
     *
-    * Retrieves persistent calibration data from EEPROM and determines if values are valid
+    * Retrieves the active profile from EEPROM and determines if values are valid
     * (by checking CRC). If valid, calibration data[] is populated, else default values
-    * of zero offset and unity gain are used.
+    * of zero offset and unity gain are used. If EEPROM holds no profile directory, the
+    * directory is created, migrating any calibration data stored by earlier firmware; if it
+    * holds a version 1 directory, its profiles are converted.
+    *
+    * EEPROM is only read when it has changed since the last recall (i.e. on the first
+    * call and after update() writes); otherwise this returns immediately, so it is
+    * cheap to call each time through the scheduler.
     */
     void recall(void) {
-        EEPROM.get(CALIBRATION_DATA_ADDRESS, eeprom_data);
+        if (!data_dirty) {
+            return;
+        }
+        data_dirty = false;
+
+        EEPROM.get(EEPROM_CALIBRATION_DIRECTORY, directory);
+        const bool found = directory.crc == Crc16::compute(reinterpret_cast<uint8_t*>(&directory), directory_crc_length);
+        if (!found || directory.version != CALIBRATION_PROFILE_VERSION || directory.active >= CALIBRATION_PROFILES) {
+            migrate(found ? directory.version : 0);
+        }
+
         data_recalled = true;
-        uint16_t check_crc = calcCRC16(reinterpret_cast<uint8_t*>(&eeprom_data), sizeof(eeprom_data) - sizeof(eeprom_data.crc));
-        if (eeprom_data.crc == check_crc) {
+        if (readProfile(directory.active, calibration_data)) {
             data_valid = true;
-            calibration_data = &eeprom_data;
             return;
         }
 
         // If data hasn't been set or has been corrupted, use the default data
         data_valid = false;
-        calibration_data = &calibration_defaults;
+        defaults(calibration_data);
         return;
     }
 
@@ -114,12 +220,16 @@ namespace Calibration {
     *
     * @param actuals      Array of voltage and current readings containing the
     *                     actual values that *should* have been set by the technician
-    *                     during the calibration procedure.
+    *                     during the calibration procedure; MEASURED_SLOTS per output.
     * @param measured     Array of voltage and current readings containing the
-    *                     measured values taken during the calibration procedure.
+    *                     measured values taken during the calibration procedure;
+    *                     MEASURED_SLOTS per output.
     */
     void update(int16_t actuals[], int16_t measured[]) {
         // Perform computations here; does nothing for now
+
+        // Force the next recall() to reload from EEPROM
+        data_dirty = true;
         return;
     }
 
@@ -131,8 +241,8 @@ namespace Calibration {
     * technician was *supposed* to set) and the measured readings. Computes CRC and updates
     * EEPROM with the new values.
     *
-    * @param param_id     Identifies specific parameter is being corrected. Use DATA_SELECT_VALUE
-    *                     enum defined in Calibration.h.
+    * @param param_id     Identifies specific parameter is being corrected: the index of the
+    *                     reading, MONITOR_SELECT_GROUP + output (see MonitorTask.h).
     *
     * @param value        Voltage or current to be corrected.
     */
@@ -142,4 +252,239 @@ namespace Calibration {
         return value;
     }
 
+    /**
+    * @brief Gets the profile in use.
+    *
+    * @return Profile number, 0 - CALIBRATION_PROFILES - 1
+    */
+    uint8_t activeProfile(void) {
+        return directory.active;
+    }
+
+    /**
+    * @brief Switches to another profile; its corrections are used from now on.
+    *
+    * @param index   Profile number, 0 - CALIBRATION_PROFILES - 1
+    *
+    * @return False if the profile does not exist or is corrupt, or a saved profile is still
+    *         being written; the profile in use is unchanged
+    */
+    bool selectProfile(const uint8_t index) {
+        cal_profile profile;
+        if (index >= CALIBRATION_PROFILES || EepromWriter::busy() || !readProfile(index, profile)) {
+            return false;
+        }
+        calibration_data = profile;
+        data_valid = true;
+        directory.active = index;
+        writeDirectory();
+        return true;
+    }
+
+    /**
+    * @brief Switches to the next valid profile after the one in use, wrapping around.
+    *
+    * @return False if no other profile is valid
+    */
+    bool nextProfile(void) {
+        for (auto step = uint8_t{1}; step < CALIBRATION_PROFILES; step++) {
+            if (selectProfile((directory.active + step) % CALIBRATION_PROFILES)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+    * @brief Stores the corrections in use as a profile, and switches to it.
+    *
+    * The profile is written from the corrections in use, so until EepromWriter::busy() is
+    * false no profile can be selected or saved.
+    *
+    * @param index   Profile number, 0 - CALIBRATION_PROFILES - 1
+    * @param name    Profile name; truncated to CALIBRATION_NAME_LENGTH characters
+    *
+    * @return False if index is out of range, or a saved profile is still being written
+    */
+    bool saveProfile(const uint8_t index, const char *name) {
+        if (index >= CALIBRATION_PROFILES || EepromWriter::busy()) {
+            return false;
+        }
+        memset(calibration_data.name, 0, sizeof(calibration_data.name));
+        strncpy(calibration_data.name, name, sizeof(calibration_data.name));
+        stampProfile(calibration_data);
+        EepromWriter::put(profileAddress(index), &calibration_data, sizeof(calibration_data));
+        data_valid = true;
+        directory.active = index;
+        writeDirectory();
+        return true;
+    }
+
+    /**
+    * @brief Gets the name of a profile.
+    *
+    * @param index       Profile number, 0 - CALIBRATION_PROFILES - 1
+    * @param[out] name   Returns the name, nul terminated; at least CALIBRATION_NAME_LENGTH + 1 characters
+    *
+    * @return False (and an empty name) if the profile does not exist or is corrupt
+    */
+    bool profileName(const uint8_t index, char name[]) {
+        cal_profile profile;
+        name[0] = 0;
+        if (index >= CALIBRATION_PROFILES || !readProfile(index, profile)) {
+            return false;
+        }
+        memcpy(name, profile.name, CALIBRATION_NAME_LENGTH);
+        name[CALIBRATION_NAME_LENGTH] = 0;
+        return true;
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      int16_t profileAddress(const uint8_t index) {
+          return EEPROM_CALIBRATION_PROFILES + index * static_cast<int16_t>(CALIBRATION_PROFILE_SIZE);
+      }
+
+      /**
+      * @brief Reads a profile from EEPROM.
+      *
+      * @param index          Profile number
+      * @param[out] profile   Returns the profile
+      *
+      * @return False if the profile is not valid (never written, corrupt, or another format)
+      */
+      bool readProfile(const uint8_t index, cal_profile &profile) {
+          EEPROM.get(profileAddress(index), profile);
+          return profile.version == CALIBRATION_PROFILE_VERSION &&
+                 profile.crc == Crc16::compute(reinterpret_cast<uint8_t*>(&profile), profile_crc_length);
+      }
+
+      /**
+      * @brief Stamps a profile with the present version and its CRC.
+      *
+      */
+      void stampProfile(cal_profile &profile) {
+          profile.version = CALIBRATION_PROFILE_VERSION;
+          profile.crc = Crc16::compute(reinterpret_cast<uint8_t*>(&profile), profile_crc_length);
+      }
+
+      /**
+      * @brief Writes a profile to EEPROM at once, stamping its version and CRC; for migration,
+      *        whose profiles are not kept in RAM.
+      *
+      */
+      void writeProfile(const uint8_t index, cal_profile &profile) {
+          stampProfile(profile);
+          EEPROM.put(profileAddress(index), profile);
+      }
+
+      /**
+      * @brief Queues the directory to be written to EEPROM; only changed bytes are written.
+      *
+      */
+      void writeDirectory(void) {
+          directory.version = CALIBRATION_PROFILE_VERSION;
+          directory.crc = Crc16::compute(reinterpret_cast<uint8_t*>(&directory), directory_crc_length);
+          EepromWriter::put(EEPROM_CALIBRATION_DIRECTORY, &directory, sizeof(directory));
+      }
+
+      /**
+      * @brief Fills a profile with the default corrections, named DEFAULT.
+      *
+      */
+      void defaults(cal_profile &profile) {
+          profile.version = CALIBRATION_PROFILE_VERSION;
+          memcpy_P(profile.name, default_name, sizeof(profile.name));
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              memcpy_P(&profile.outputs[output], &output_defaults, sizeof(profile.outputs[output]));
+          }
+      }
+
+      /**
+      * @brief Copies corrections stored by earlier firmware into a profile.
+      *
+      * Earlier firmware indexed its corrections as the readings of two outputs (V+, V-, I+, I-);
+      * any further outputs get the default corrections.
+      *
+      * @param offsets   Offset corrections, 4 entries
+      * @param gains     Gain corrections, 4 entries
+      * @param profile   Profile to fill; its name and version are unchanged
+      */
+      void convert(const int16_t offsets[], const fixed gains[], cal_profile &profile) {
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              cal_output &corrections = profile.outputs[output];
+              if (output < 2) {
+                  corrections.offsets[0] = offsets[output];
+                  corrections.offsets[1] = offsets[2 + output];
+                  corrections.gains[0] = gains[output];
+                  corrections.gains[1] = gains[2 + output];
+              }
+              else {
+                  memcpy_P(&corrections, &output_defaults, sizeof(corrections));
+              }
+          }
+      }
+
+      /**
+      * @brief Brings the profiles and directory to the present format.
+      *
+      * @param from   Version of the directory found in EEPROM; 0 if there is none
+      */
+      void migrate(const uint8_t from) {
+          if (from == 1) {
+              migrateProfiles();
+          }
+          else if (from != CALIBRATION_PROFILE_VERSION) {
+              migrateLegacy();
+              directory.active = 0;
+          }
+          if (directory.active >= CALIBRATION_PROFILES) {
+              directory.active = 0;
+          }
+          writeDirectory();
+      }
+
+      /**
+      * @brief Moves calibration data stored by earlier firmware into profile 0.
+      *
+      */
+      void migrateLegacy(void) {
+          cal_data legacy;
+          EEPROM.get(CALIBRATION_DATA_ADDRESS, legacy);
+          if (legacy.crc == Crc16::compute(reinterpret_cast<uint8_t*>(&legacy), crc_length)) {
+              cal_profile profile;
+              memcpy_P(profile.name, default_name, sizeof(profile.name));
+              convert(legacy.offsets, legacy.gains, profile);
+              writeProfile(0, profile);
+          }
+      }
+
+      /**
+      * @brief Converts the version 1 profiles that fit in place; invalid ones stay invalid.
+      *
+      * When profiles have grown, they are converted from the last so none is overwritten
+      * before it is read; otherwise from the first.
+      */
+      void migrateProfiles(void) {
+          constexpr uint8_t count = (CALIBRATION_PROFILES < CALIBRATION_PROFILES_V1) ? CALIBRATION_PROFILES : CALIBRATION_PROFILES_V1;
+          constexpr bool grown = CALIBRATION_PROFILE_SIZE >= CALIBRATION_PROFILE_SIZE_V1;
+          for (auto n = uint8_t{0}; n < count; n++) {
+              const uint8_t index = grown ? count - 1 - n : n;
+              cal_profile_v1 old;
+              EEPROM.get(EEPROM_CALIBRATION_PROFILES + index * static_cast<int16_t>(CALIBRATION_PROFILE_SIZE_V1), old);
+              if (old.version != 1 ||
+                  old.crc != Crc16::compute(reinterpret_cast<uint8_t*>(&old), profile_v1_crc_length)) {
+                  continue;
+              }
+              cal_profile profile;
+              memcpy(profile.name, old.name, sizeof(profile.name));
+              convert(old.offsets, old.gains, profile);
+              writeProfile(index, profile);
+          }
+      }
+
+    }
+
 }
\ No newline at end of file
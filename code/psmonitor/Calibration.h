@@ -12,6 +12,12 @@
 #ifndef _CALIBRATION_H
 #define _CALIBRATION_H
 
+// EEPROM layout
+#include "eeprom_map.h"
+
+// MONITOR_OUTPUTS, and the fixed point type of the gains
+#include "MonitorTask.h"
+#include "Fixed.h"
 
 // Offsets into measured values in actuals[] and measured[] arrays
 enum MEASURED_SELECT_SLOT : int16_t {
@@ -19,27 +25,27 @@ enum MEASURED_SELECT_SLOT : int16_t {
     MEASURED_HIGH_V = 1,    // For any value in measured[], high voltage measurement
     MEASURED_LOW_I =  2,    // For any value in measured[], low current measurement
     MEASURED_HIGH_I = 3,    // For any value in measured[], high current measurement
+    MEASURED_SLOTS =  4,    // Measurements per output; those of output n start at n * MEASURED_SLOTS
 };
 
-// Calibration of positive and negative voltages use two sets of data
-// contained in actuals[] and measured[]
-enum MEASURED_SELECT_POS_NEG : int16_t {
-    MEASURED_POS = 0,
-    MEASURED_NEG = 4,
-};
 
-// Indexes into calibration data[] array; used to identify which parameter is being corrected
-enum DATA_SELECT_VALUE : int16_t {
-    DATA_VOLTAGE_POS = 0,    // Index of positive voltage entries
-    DATA_VOLTAGE_NEG = 1,    // Index of negative voltage entries
-    DATA_CURRENT_POS = 2,    // Index of positive current entries
-    DATA_CURRENT_NEG = 3,    // Index of negative current entries
-};
+// Length of calibration profile names
+constexpr uint8_t CALIBRATION_NAME_LENGTH = 7;
 
+// Bytes of EEPROM each calibration profile takes (Calibration::cal_profile): version, name and
+// CRC, and an offset and gain for the voltage and the current of each output
+constexpr uint16_t CALIBRATION_PROFILE_SIZE = 1 + CALIBRATION_NAME_LENGTH + sizeof(uint16_t) +
+                                              MONITOR_OUTPUTS * 2 * (sizeof(int16_t) + sizeof(fixed));
+
+// Number of calibration profiles: as many as fit their EEPROM space, up to 4
+constexpr uint8_t CALIBRATION_PROFILES =
+    ((EEPROM_CALIBRATION_PROFILES_END - EEPROM_CALIBRATION_PROFILES) / CALIBRATION_PROFILE_SIZE < 4) ?
+    (EEPROM_CALIBRATION_PROFILES_END - EEPROM_CALIBRATION_PROFILES) / CALIBRATION_PROFILE_SIZE : 4;
 
 namespace Calibration {
 
-    const auto CALIBRATION_DATA_ADDRESS = int16_t{0};
+    // Address of the single calibration record kept by earlier firmware (migrated to profile 0)
+    const auto CALIBRATION_DATA_ADDRESS = int16_t{EEPROM_CALIBRATION};
 
     bool calibrated(void);
     void recall(void);
@@ -47,6 +53,13 @@ namespace Calibration {
 
     int16_t correct(const int16_t param_id, const int16_t value);
 
+    // Calibration profiles
+    uint8_t activeProfile(void);
+    bool selectProfile(const uint8_t index);
+    bool nextProfile(void);
+    bool saveProfile(const uint8_t index, const char *name);
+    bool profileName(const uint8_t index, char name[]);
+
 }
 
 #endif
@@ -0,0 +1,257 @@
+/**
+ * @file CaptureTask.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a CaptureTask that records transients around a trigger (scope mode).
+ *
+ * Implements a CaptureTask that samples all four channels as fast as the sensors and I2C bus
+ * allow into a circular buffer. Once the buffer holds the requested number of pre-trigger
+ * samples, the trigger is armed: when the trigger channel crosses the trigger level in the
+ * chosen direction, the remaining buffer is filled with post-trigger samples and the buffer
+ * is frozen until it is dumped (over the serial port) and the capture re-armed.
+ *
+ * The trigger test is a single compare of the trigger channel against the level and the
+ * previous sample, so it costs the same for every sample. The buffer uses CAPTURE_BUFFER_SIZE
+ * bytes of RAM, so it holds fewer sample sets the more outputs are monitored.
+ *
+ * To use the Capture task:
+ *      - CaptureTask::setup() - setup the task
+ *      - CaptureTask::start() - reconfigure the sensors for fast sampling and arm; call when entering capture mode
+ *      - CaptureTask::stop() - restore the sensor configuration; call when leaving capture mode
+ *      - CaptureTask::update() - run the capture; call once each time through scheduler
+ *      - CaptureTask::arm() - discard the capture and start a new one
+ *      - CaptureTask::setTrigger() / CaptureTask::getTrigger() - trigger channel, level, slope and pre-trigger samples
+ *      - CaptureTask::state(), CaptureTask::samplePeriod(), CaptureTask::getFrame() - results
+ *
+ * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
+ * is responsible for relinquishing control; this code is *not threadsafe* and must not be
+ * interrupted.
+ */
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// Include our own header file
+#include "CaptureTask.h"
+
+// Include the Monitor task that owns the sensors
+#include "MonitorTask.h"
+
+// Limits on power supply output voltages and currents
+#include "limits.h"
+
+namespace CaptureTask {
+
+    // Sample sets read each time the task runs (bounds run time)
+    constexpr uint8_t CAPTURE_BURST = 8;
+
+    // Capture buffer; frames[head] is the next slot to write
+    int16_t frames[CAPTURE_FRAMES][MONITOR_VALUES];
+    static_assert(sizeof(frames) <= CAPTURE_BUFFER_SIZE && CAPTURE_FRAMES >= 8, "Capture buffer must fit in the Nano's RAM budget");
+    auto head = uint8_t{0};
+    auto count = uint8_t{0};          // Frames written since arming (saturates at CAPTURE_FRAMES)
+    auto remaining = uint8_t{0};      // Post-trigger frames still to record
+    auto currentState = uint8_t{CAPTURE_FILLING};
+    auto previous = int16_t{};        // Previous sample of the trigger channel
+
+    // Trigger settings
+    auto triggerChannel = uint8_t{MONITOR_CURRENT};
+    auto triggerLevel = int16_t{LIMIT_MAX_CURRENT};
+    auto triggerSlope = uint8_t{SLOPE_RISING};
+    auto pretrigger = uint8_t{CAPTURE_FRAMES / 4};
+
+    // Sample timing
+    auto triggerTime = uint32_t{};
+    auto period = uint16_t{0};        // Microseconds per sample set after the trigger
+
+    LiquidCrystal *lcd = nullptr;
+
+    // Forward declarations of functions used only in this task
+    namespace
+    {
+
+      void display(void);
+
+    }
+
+    /**
+    * @brief Configures the capture task LCD display.
+    *
+    * @param display   Pointer to the LCD display object
+    */
+    void setup(LiquidCrystal *display) {
+        lcd = display;
+    }
+
+    /**
+    * @brief Reconfigures the sensors and I2C bus for fast sampling and arms a capture.
+    *
+    */
+    void start(void) {
+        MonitorTask::setFastSampling(true);
+        arm();
+    }
+
+    /**
+    * @brief Restores the sensor and I2C bus configuration in use before start().
+    *
+    */
+    void stop(void) {
+        MonitorTask::setFastSampling(false);
+    }
+
+    /**
+    * @brief Discards any capture and starts collecting pre-trigger samples.
+    *
+    */
+    void arm(void) {
+        head = 0;
+        count = 0;
+        currentState = CAPTURE_FILLING;
+        display();
+    }
+
+    /**
+    * @brief Called each time through the scheduling loop to sample and test the trigger.
+    *
+    * Reads up to CAPTURE_BURST sample sets; does nothing once the capture is complete.
+    */
+    void update(void) {
+        for (auto n = uint8_t{0}; n < CAPTURE_BURST && currentState != CAPTURE_DONE; n++) {
+            int16_t *frame = frames[head];
+            MonitorTask::readFrame(frame);
+            head = (head + 1 < CAPTURE_FRAMES) ? head + 1 : 0;
+            if (count < CAPTURE_FRAMES) {
+                count++;
+            }
+
+            const int16_t value = frame[triggerChannel];
+            switch (currentState) {
+            case CAPTURE_FILLING:
+                if (count >= pretrigger) {
+                    currentState = CAPTURE_ARMED;
+                    display();
+                }
+                break;
+            case CAPTURE_ARMED:
+                if ((triggerSlope == SLOPE_RISING) ? (previous < triggerLevel && value >= triggerLevel)
+                                                   : (previous > triggerLevel && value <= triggerLevel)) {
+                    currentState = CAPTURE_TRIGGERED;
+                    remaining = CAPTURE_FRAMES - pretrigger - 1;
+                    triggerTime = micros();
+                    display();
+                }
+                break;
+            case CAPTURE_TRIGGERED:
+            default:
+                if (--remaining == 0) {
+                    period = static_cast<uint16_t>((micros() - triggerTime) / (CAPTURE_FRAMES - pretrigger - 1));
+                    currentState = CAPTURE_DONE;
+                    display();
+                }
+                break;
+            }
+            previous = value;
+        }
+    }
+
+    /**
+    * @brief Sets the trigger; re-arms the capture.
+    *
+    * @param channel      Channel to trigger on (MONITOR_SELECT_GROUP + output)
+    * @param level        Trigger level in millivolts or milliamps
+    * @param slope        CAPTURE_SLOPE
+    * @param samples      Number of samples to keep from before the trigger
+    *
+    * @return False if any setting is out of range
+    */
+    bool setTrigger(const uint8_t channel, const int16_t level, const uint8_t slope, const uint8_t samples) {
+        if (channel >= MONITOR_VALUES || (slope != SLOPE_RISING && slope != SLOPE_FALLING) ||
+            samples < 1 || samples > CAPTURE_FRAMES - 2) {
+            return false;
+        }
+        triggerChannel = channel;
+        triggerLevel = level;
+        triggerSlope = slope;
+        pretrigger = samples;
+        arm();
+        return true;
+    }
+
+    void getTrigger(uint8_t &channel, int16_t &level, uint8_t &slope, uint8_t &samples) {
+        channel = triggerChannel;
+        level = triggerLevel;
+        slope = triggerSlope;
+        samples = pretrigger;
+    }
+
+    /**
+    * @brief Gets the state of the capture.
+    *
+    * @return CAPTURE_STATE
+    */
+    uint8_t state(void) {
+        return currentState;
+    }
+
+    /**
+    * @brief Gets the average time between sample sets recorded after the trigger.
+    *
+    * @return Microseconds per sample set (0 until a capture completes)
+    */
+    uint16_t samplePeriod(void) {
+        return period;
+    }
+
+    /**
+    * @brief Retrieves a frame of a completed capture, oldest first.
+    *
+    * The trigger sample is frame number (pre-trigger samples).
+    *
+    * @param index        Frame number, 0 - CAPTURE_FRAMES - 1
+    * @param[out] frame   Returns the frame, indexed by MONITOR_SELECT_GROUP + output
+    *
+    * @return False if the capture is not complete or index is out of range
+    */
+    bool getFrame(const uint8_t index, int16_t frame[]) {
+        if (currentState != CAPTURE_DONE || index >= CAPTURE_FRAMES) {
+            return false;
+        }
+        // When done, the buffer is full and frames[head] is the oldest frame
+        const uint8_t slot = (head + index) % CAPTURE_FRAMES;
+        memcpy(frame, frames[slot], sizeof(frames[slot]));
+        return true;
+    }
+
+    // Functions used only in this task
+    namespace
+    {
+
+      /**
+      * @brief Displays the capture state.
+      *
+      */
+      void display(void) {
+          lcd->setCursor(0, 0);
+          switch (currentState) {
+          case CAPTURE_FILLING:
+              lcd->print(F("Capture: filling"));
+              break;
+          case CAPTURE_ARMED:
+              lcd->print(F("Capture: armed  "));
+              break;
+          case CAPTURE_TRIGGERED:
+              lcd->print(F("Capture: trig'd "));
+              break;
+          case CAPTURE_DONE:
+          default:
+              lcd->print(F("Capture: done   "));
+              break;
+          }
+      }
+
+    }
+
+}
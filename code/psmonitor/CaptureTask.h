@@ -0,0 +1,55 @@
+#pragma once
+/**
+ * @file CaptureTask.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for CaptureTask.
+ *
+ */
+
+#ifndef _CAPTURETASK_H
+#define _CAPTURETASK_H
+
+// Include headers for third party libraries
+#include <LiquidCrystal.h>
+
+// MONITOR_VALUES
+#include "MonitorTask.h"
+
+// States of a capture
+enum CAPTURE_STATE : uint8_t {
+    CAPTURE_FILLING,      // Collecting pre-trigger samples; trigger not yet armed
+    CAPTURE_ARMED,        // Waiting for the trigger
+    CAPTURE_TRIGGERED,    // Collecting post-trigger samples
+    CAPTURE_DONE,         // Buffer frozen; ready to dump
+};
+
+// Trigger slopes
+enum CAPTURE_SLOPE : uint8_t {
+    SLOPE_RISING = 1,     // Reading rises through the level
+    SLOPE_FALLING = 2,    // Reading falls through the level
+};
+
+// Capture buffer RAM budget in bytes, and the sample sets it holds (2 bytes per value)
+constexpr uint16_t CAPTURE_BUFFER_SIZE = 320;
+constexpr uint8_t CAPTURE_FRAMES = CAPTURE_BUFFER_SIZE / (MONITOR_VALUES * sizeof(int16_t));
+
+namespace CaptureTask {
+
+    void setup(LiquidCrystal *display);
+    void start(void);
+    void stop(void);
+    void update(void);
+    void arm(void);
+
+    bool setTrigger(const uint8_t channel, const int16_t level, const uint8_t slope, const uint8_t pretrigger);
+    void getTrigger(uint8_t &channel, int16_t &level, uint8_t &slope, uint8_t &pretrigger);
+    uint8_t state(void);
+    uint16_t samplePeriod(void);
+    bool getFrame(const uint8_t index, int16_t frame[]);
+
+}
+
+#endif
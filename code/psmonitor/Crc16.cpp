@@ -0,0 +1,54 @@
+/**
+ * @file Crc16.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Computes the CRC16 used to validate data stored in EEPROM.
+ *
+ * Runtime CRCs are table driven, a nibble (4 bits) at a time, using a 16 entry
+ * table held in PROGMEM. The table entries are generated at compile time from the
+ * bitwise constexpr form in Crc16.h, so both forms always agree.
+ *
+ */
+
+// Standard header files
+#include <Arduino.h>
+
+// Include our own header file
+#include "Crc16.h"
+
+namespace Crc16 {
+
+    // Standard check value for this CRC variant
+    static_assert(update(update(update(update(update(update(update(update(update(0,
+                  '1'), '2'), '3'), '4'), '5'), '6'), '7'), '8'), '9') == 0xA829,
+                  "CRC16 check value mismatch");
+
+    // CRC of each possible nibble shifted out of the top of the CRC register
+    const uint16_t nibble_table[16] PROGMEM = {
+        shift(0x0000, 4), shift(0x1000, 4), shift(0x2000, 4), shift(0x3000, 4),
+        shift(0x4000, 4), shift(0x5000, 4), shift(0x6000, 4), shift(0x7000, 4),
+        shift(0x8000, 4), shift(0x9000, 4), shift(0xA000, 4), shift(0xB000, 4),
+        shift(0xC000, 4), shift(0xD000, 4), shift(0xE000, 4), shift(0xF000, 4),
+    };
+
+    /**
+    * @brief Computes the CRC16 of a block of memory.
+    *
+    * @param data     Pointer to the first byte of the block
+    * @param length   Number of bytes in the block
+    *
+    * @return CRC16 of the block
+    */
+    uint16_t compute(const uint8_t *data, uint16_t length) {
+        auto crc = uint16_t{0};
+        while (length--) {
+            const uint8_t value = *data++;
+            crc = (crc << 4) ^ pgm_read_word(&nibble_table[(crc >> 12) ^ (value >> 4)]);
+            crc = (crc << 4) ^ pgm_read_word(&nibble_table[(crc >> 12) ^ (value & 0x0F)]);
+        }
+        return crc;
+    }
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+/**
+ * @file Crc16.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining the CRC16 used to validate data stored in EEPROM.
+ *
+ * Non-reflected CRC16, polynomial 0x8001, zero initial value and no final xor
+ * (the defaults of calcCRC16() in the CRC library originally used here, so
+ * existing EEPROM records remain valid). The constexpr forms allow CRCs of
+ * constant data to be computed at compile time.
+ *
+ */
+
+#ifndef _CRC16_H
+#define _CRC16_H
+
+namespace Crc16 {
+
+    constexpr uint16_t polynomial = 0x8001;
+
+    /// Shifts @p bits bits out of the CRC register (bitwise, MSB first)
+    constexpr uint16_t shift(const uint16_t crc, const uint8_t bits) {
+        return (bits == 0) ? crc
+                           : shift(static_cast<uint16_t>((crc & 0x8000) ? ((crc << 1) ^ polynomial) : (crc << 1)), bits - 1);
+    }
+
+    /// Feeds one byte into the CRC
+    constexpr uint16_t update(const uint16_t crc, const uint8_t value) {
+        return shift(static_cast<uint16_t>(crc ^ (static_cast<uint16_t>(value) << 8)), 8);
+    }
+
+    /// Feeds a 16 bit value into the CRC in memory (little endian) byte order
+    constexpr uint16_t update16(const uint16_t crc, const uint16_t value) {
+        return update(update(crc, static_cast<uint8_t>(value)), static_cast<uint8_t>(value >> 8));
+    }
+
+    /// Feeds a 32 bit value into the CRC in memory (little endian) byte order
+    constexpr uint16_t update32(const uint16_t crc, const uint32_t value) {
+        return update16(update16(crc, static_cast<uint16_t>(value)), static_cast<uint16_t>(value >> 16));
+    }
+
+    uint16_t compute(const uint8_t *data, uint16_t length);
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file EepromWriter.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Writes settings records to EEPROM a byte at a time, so that saving never waits on the EEPROM.
+ *
+ * Modules that keep a settings record in RAM (alert rules, calibration profiles, tracking
+ * limits) queue it with put() rather than writing it with EEPROM.put(), which waits 3.3ms
+ * for each changed byte. update() then writes one byte each time it runs, and only when the
+ * EEPROM is ready, as EventLog::update() does; unchanged bytes are skipped. The record is
+ * read from RAM as it is written, so it must stay in place: queueing the same record again
+ * (e.g. after it is changed and its CRC updated) starts it over rather than adding an entry.
+ *
+ * If the queue is full, the record is written at once instead.
+ *
+ * To use the writer:
+ *      - EepromWriter::put() - queue a record; the data must stay valid until written
+ *      - EepromWriter::update() - write a queued byte; call once each time through scheduler
+ *      - EepromWriter::busy() - true until every queued record has been written
+ */
+
+// Include standard headers as needed
+#include <avr/eeprom.h>
+#include <EEPROM.h>
+
+// Include our own header file
+#include "EepromWriter.h"
+
+namespace EepromWriter {
+
+    /// A record waiting to be written
+    struct eeprom_write {
+        int16_t address;                // First EEPROM address
+        const uint8_t *data;            // Record in RAM
+        uint16_t length;                // Bytes in the record
+    };
+
+    eeprom_write queue[EEPROM_WRITE_QUEUE_LENGTH];
+    auto queueHead = uint8_t{0};
+    auto queueCount = uint8_t{0};
+    auto writeStep = uint16_t{0};       // Next byte of the record at the head of the queue
+
+    /**
+    * @brief Queues a record to be written to EEPROM.
+    *
+    * @param address   First EEPROM address
+    * @param data      Record; read as it is written, so it must not go out of scope
+    * @param length    Bytes in the record
+    */
+    void put(const int16_t address, const void *data, const uint16_t length) {
+        const uint8_t *bytes = static_cast<const uint8_t*>(data);
+        for (auto n = uint8_t{0}; n < queueCount; n++) {
+            eeprom_write &entry = queue[(queueHead + n) % EEPROM_WRITE_QUEUE_LENGTH];
+            if (entry.address == address && entry.data == bytes) {
+                entry.length = length;
+                if (n == 0) {
+                    writeStep = 0;
+                }
+                return;
+            }
+        }
+        if (queueCount == EEPROM_WRITE_QUEUE_LENGTH) {
+            eeprom_update_block(bytes, reinterpret_cast<void*>(address), length);
+            return;
+        }
+        queue[(queueHead + queueCount) % EEPROM_WRITE_QUEUE_LENGTH] = eeprom_write{address, bytes, length};
+        queueCount++;
+    }
+
+    /**
+    * @brief Writes the next byte of the oldest queued record, if the EEPROM is ready.
+    *
+    */
+    void update(void) {
+        if (queueCount == 0 || !eeprom_is_ready()) {
+            return;
+        }
+
+        const eeprom_write &entry = queue[queueHead];
+        EEPROM.update(entry.address + writeStep, entry.data[writeStep]);
+        if (++writeStep < entry.length) {
+            return;
+        }
+
+        // The record is complete
+        writeStep = 0;
+        queueHead = (queueHead + 1) % EEPROM_WRITE_QUEUE_LENGTH;
+        queueCount--;
+    }
+
+    /**
+    * @brief Checks for records still to be written.
+    *
+    * @return True while any queued record is not completely written
+    */
+    bool busy(void) {
+        return queueCount > 0;
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+/**
+ * @file EepromWriter.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining deferred writes of settings to EEPROM.
+ *
+ */
+
+#ifndef _EEPROMWRITER_H
+#define _EEPROMWRITER_H
+
+#include <Arduino.h>
+
+// Number of settings records that can wait to be written
+constexpr uint8_t EEPROM_WRITE_QUEUE_LENGTH = 4;
+
+namespace EepromWriter {
+
+    void put(const int16_t address, const void *data, const uint16_t length);
+    void update(void);
+    bool busy(void);
+
+}
+
+#endif
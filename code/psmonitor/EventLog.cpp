@@ -0,0 +1,337 @@
+/**
+ * @file EventLog.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Keeps a persistent log of over-limit events: each alert, with its peak reading and duration.
+ *
+ * Every set of readings checked against the alert rules is passed to record() with the rules
+ * alerting. When a rule starts alerting its start time and channel are noted, and its peak
+ * is tracked while it alerts; when it clears, the event is queued in RAM. This is all the
+ * acquisition path pays: a couple of comparisons when nothing is alerting, and at most one
+ * comparison per alerting rule otherwise (plus a rule lookup or a queue entry on the set
+ * where a rule starts or stops alerting).
+ *
+ * Queued events are written to a ring of EVENT_LOG_SLOTS entries in EEPROM by update(), one
+ * byte each time it runs and only when the EEPROM is ready, so writing never waits on the
+ * EEPROM's 3.3ms write time. Events go to consecutive slots, so every slot is written once per
+ * EVENT_LOG_SLOTS events and the wear is spread across the ring. Each entry carries a sequence
+ * number: a slot's sequence number is erased before the rest of the entry is written and
+ * written last, so an entry torn by a reset is never read back, and at startup the newest
+ * entry is found as the end of the run of consecutive sequence numbers.
+ *
+ * If more than EVENT_QUEUE_LENGTH events finish before they can be written, later events are
+ * counted as dropped. Uptimes are reset with the processor; events are not tied to a date.
+ *
+ * To use the event log:
+ *      - EventLog::setup() - find the newest event in EEPROM
+ *      - EventLog::record() - track alerts; call with the rules alerting after each set of readings
+ *      - EventLog::update() - write queued events to EEPROM; call once each time through scheduler
+ *      - EventLog::count(), EventLog::entry() - read the log, newest first
+ *      - EventLog::dropped() - events lost because the queue was full
+ *      - EventLog::clear() - erase the log
+ */
+
+// Include standard headers as needed
+#include <avr/eeprom.h>
+#include <EEPROM.h>
+#include <stddef.h>
+
+// Include our own header file
+#include "EventLog.h"
+
+// Alert rules whose transitions are logged
+#include "Alerts.h"
+
+// EEPROM layout
+#include "eeprom_map.h"
+
+namespace EventLog {
+
+    static_assert(sizeof(event_entry) * EVENT_LOG_SLOTS <= EEPROM_EVENT_LOG_END - EEPROM_EVENT_LOG,
+                  "Event log must fit in its EEPROM space");
+    static_assert(offsetof(event_entry, sequence) == 0, "Sequence number must come first");
+
+    // Sequence number of an erased slot; never given to an event
+    constexpr uint16_t EMPTY = 0xFFFF;
+
+    // Steps taken by update() to write an entry: erase the sequence number, write the rest
+    // of the entry, then write the sequence number
+    constexpr uint8_t WRITE_STEPS = sizeof(event_entry) + sizeof(uint16_t);
+
+    // Alerts in progress, one bit or element per rule
+    auto activeRules = alert_mask{0};
+    auto underRules = alert_mask{0};    // Rules alerting below their threshold; peak is the minimum
+    uint8_t channels[ALERT_RULES];
+    int16_t peaks[ALERT_RULES];
+    uint32_t starts[ALERT_RULES];
+
+    // Finished events not yet written to EEPROM, oldest first
+    event_entry queue[EVENT_QUEUE_LENGTH];
+    auto queueHead = uint8_t{0};
+    auto queueCount = uint8_t{0};
+    auto nextSequence = uint16_t{0};
+    auto droppedEvents = uint16_t{0};
+
+    // EEPROM ring
+    auto writeSlot = uint8_t{0};        // Slot the next event is written to
+    auto writeStep = uint8_t{0};        // Progress writing the oldest queued event
+    auto stored = uint8_t{0};           // Events in EEPROM, ending with the slot before writeSlot
+    auto clearing = uint8_t{0};         // Sequence number bytes still to erase
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      void begin(const uint8_t index, const int16_t values[]);
+      void finish(const uint8_t index);
+      int16_t slotAddress(const uint8_t slot);
+      uint16_t readSequence(const uint8_t slot);
+      uint16_t following(const uint16_t sequence);
+      uint16_t preceding(const uint16_t sequence);
+
+    }
+
+    /**
+    * @brief Finds the newest event in EEPROM and the length of the log ending there.
+    *
+    * The newest event is the end of a run of consecutive sequence numbers; if a reset left
+    * more than one run (e.g. while the log was being cleared), the run with the highest
+    * sequence number is used.
+    */
+    void setup(void) {
+        auto latest = uint8_t{EVENT_LOG_SLOTS};
+        auto latestSequence = uint16_t{0};
+        for (auto slot = uint8_t{0}; slot < EVENT_LOG_SLOTS; slot++) {
+            const uint16_t sequence = readSequence(slot);
+            if (sequence == EMPTY || readSequence((slot + 1) % EVENT_LOG_SLOTS) == following(sequence)) {
+                continue;
+            }
+            if (latest == EVENT_LOG_SLOTS || static_cast<int16_t>(sequence - latestSequence) > 0) {
+                latest = slot;
+                latestSequence = sequence;
+            }
+        }
+
+        activeRules = 0;
+        queueCount = 0;
+        writeStep = 0;
+        stored = 0;
+        if (latest == EVENT_LOG_SLOTS) {
+            writeSlot = 0;
+            nextSequence = 0;
+            return;
+        }
+        writeSlot = (latest + 1) % EVENT_LOG_SLOTS;
+        nextSequence = following(latestSequence);
+        for (auto expected = latestSequence; stored < EVENT_LOG_SLOTS; expected = preceding(expected)) {
+            if (readSequence((latest + EVENT_LOG_SLOTS - stored) % EVENT_LOG_SLOTS) != expected) {
+                break;
+            }
+            stored++;
+        }
+    }
+
+    /**
+    * @brief Tracks the alert rules; queues an event each time a rule stops alerting.
+    *
+    * @param active   Bit mask of rules currently alerting (from Alerts::evaluate())
+    * @param values   Array of readings indexed by MONITOR_SELECT_GROUP + output
+    */
+    void record(const alert_mask active, const int16_t values[]) {
+        const alert_mask changed = active ^ activeRules;
+        if ((active | changed) == 0) {
+            return;
+        }
+
+        auto mask = alert_mask{1};
+        for (auto index = uint8_t{0}; index < ALERT_RULES; index++, mask <<= 1) {
+            if (changed & mask) {
+                if (active & mask) {
+                    begin(index, values);
+                }
+                else {
+                    finish(index);
+                }
+            }
+            else if (active & mask) {
+                const int16_t value = values[channels[index]];
+                if ((underRules & mask) ? value < peaks[index] : value > peaks[index]) {
+                    peaks[index] = value;
+                }
+            }
+        }
+        activeRules = active;
+    }
+
+    /**
+    * @brief Writes the next byte of the log to EEPROM, if the EEPROM is ready.
+    *
+    * Only bytes that have changed are written.
+    */
+    void update(void) {
+        if (!eeprom_is_ready()) {
+            return;
+        }
+        if (clearing > 0) {
+            clearing--;
+            EEPROM.update(slotAddress(clearing >> 1) + (clearing & 1), 0xFF);
+            return;
+        }
+        if (queueCount == 0) {
+            return;
+        }
+
+        const event_entry &event = queue[queueHead];
+        const uint8_t *bytes = reinterpret_cast<const uint8_t*>(&event);
+        const int16_t address = slotAddress(writeSlot);
+        if (writeStep < sizeof(uint16_t)) {
+            // Erase the sequence number first; the oldest event is lost once the ring is full
+            if (writeStep == 0 && stored == EVENT_LOG_SLOTS) {
+                stored--;
+            }
+            EEPROM.update(address + writeStep, 0xFF);
+        }
+        else if (writeStep < sizeof(event_entry)) {
+            EEPROM.update(address + writeStep, bytes[writeStep]);
+        }
+        else {
+            const uint8_t offset = writeStep - sizeof(event_entry);
+            EEPROM.update(address + offset, bytes[offset]);
+        }
+        if (++writeStep < WRITE_STEPS) {
+            return;
+        }
+
+        // The entry is complete
+        writeStep = 0;
+        writeSlot = (writeSlot + 1) % EVENT_LOG_SLOTS;
+        stored++;
+        queueHead = (queueHead + 1) % EVENT_QUEUE_LENGTH;
+        queueCount--;
+    }
+
+    /**
+    * @brief Erases the log; the EEPROM is erased a byte at a time by update().
+    *
+    * Alerts in progress are logged when they clear.
+    */
+    void clear(void) {
+        queueCount = 0;
+        writeStep = 0;
+        stored = 0;
+        droppedEvents = 0;
+        clearing = EVENT_LOG_SLOTS * sizeof(uint16_t);
+    }
+
+    /**
+    * @brief Gets the number of events in the log.
+    *
+    * @return Events queued and in EEPROM
+    */
+    uint8_t count(void) {
+        return queueCount + stored;
+    }
+
+    /**
+    * @brief Retrieves an event from the log.
+    *
+    * @param index       Event, 0 for the newest
+    * @param[out] event  Returns the event
+    *
+    * @return False if there is no such event
+    */
+    bool entry(const uint8_t index, event_entry &event) {
+        if (index < queueCount) {
+            event = queue[(queueHead + queueCount - 1 - index) % EVENT_QUEUE_LENGTH];
+            return true;
+        }
+        const uint8_t age = index - queueCount;
+        if (age >= stored) {
+            return false;
+        }
+        EEPROM.get(slotAddress((writeSlot + EVENT_LOG_SLOTS - 1 - age) % EVENT_LOG_SLOTS), event);
+        return event.sequence != EMPTY;
+    }
+
+    /**
+    * @brief Gets the number of events lost because they finished faster than they could be written.
+    *
+    * @return Events dropped since startup (or the log was cleared); saturates
+    */
+    uint16_t dropped(void) {
+        return droppedEvents;
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      /**
+      * @brief Notes the start of an alert.
+      *
+      * @param index    Rule number
+      * @param values   Array of readings indexed by MONITOR_SELECT_GROUP + output
+      */
+      void begin(const uint8_t index, const int16_t values[]) {
+          alert_rule rule;
+          (void) Alerts::getRule(index, rule);
+          const alert_mask mask = alert_mask{1} << index;
+          if (rule.type == ALERT_UNDER) {
+              underRules |= mask;
+          }
+          else {
+              underRules &= ~mask;
+          }
+          channels[index] = rule.channel;
+          peaks[index] = values[rule.channel];
+          starts[index] = millis();
+      }
+
+      /**
+      * @brief Queues the event for an alert that has cleared.
+      *
+      * @param index   Rule number
+      */
+      void finish(const uint8_t index) {
+          if (queueCount == EVENT_QUEUE_LENGTH) {
+              if (droppedEvents != UINT16_MAX) {
+                  droppedEvents++;
+              }
+              return;
+          }
+          const uint32_t duration = (millis() - starts[index]) >> EVENT_DURATION_SHIFT;
+
+          event_entry &event = queue[(queueHead + queueCount) % EVENT_QUEUE_LENGTH];
+          event.sequence = nextSequence;
+          event.duration = (duration < UINT16_MAX) ? duration : UINT16_MAX;
+          event.uptime = starts[index];
+          event.peak = peaks[index];
+          event.rule = index;
+          event.channel = channels[index];
+          nextSequence = following(nextSequence);
+          queueCount++;
+      }
+
+      int16_t slotAddress(const uint8_t slot) {
+          return EEPROM_EVENT_LOG + slot * sizeof(event_entry);
+      }
+
+      uint16_t readSequence(const uint8_t slot) {
+          uint16_t sequence;
+          return EEPROM.get(slotAddress(slot), sequence);
+      }
+
+      // Sequence numbers count up to EMPTY - 1, then start again from 0
+      uint16_t following(const uint16_t sequence) {
+          return (sequence == EMPTY - 1) ? 0 : sequence + 1;
+      }
+
+      uint16_t preceding(const uint16_t sequence) {
+          return (sequence == 0) ? EMPTY - 1 : sequence - 1;
+      }
+
+    }
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * @file EventLog.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining the persistent log of over-limit events.
+ *
+ */
+
+#ifndef _EVENTLOG_H
+#define _EVENTLOG_H
+
+#include <Arduino.h>
+
+// ALERT_RULES, alert_mask
+#include "Alerts.h"
+
+// Number of events kept in EEPROM; the oldest is overwritten by the next
+constexpr uint8_t EVENT_LOG_SLOTS = 40;
+
+// Number of finished events held in RAM until written to EEPROM
+constexpr uint8_t EVENT_QUEUE_LENGTH = 4;
+
+// Event durations are kept in units of 2^EVENT_DURATION_SHIFT milliseconds (about 70 minutes at most)
+constexpr uint8_t EVENT_DURATION_SHIFT = 6;
+
+/// An alert, from when its rule started alerting until it cleared
+struct event_entry {
+    uint16_t sequence;  // Event number; consecutive events have consecutive numbers
+    uint16_t duration;  // Time alerting, in units of 2^EVENT_DURATION_SHIFT ms; saturates
+    uint32_t uptime;    // millis() when the rule started alerting
+    int16_t peak;       // Furthest reading beyond the threshold, in mV or mA
+    uint8_t rule;       // Alert rule number
+    uint8_t channel;    // Index into a set of readings (MONITOR_SELECT_GROUP + output)
+};
+
+namespace EventLog {
+
+    void setup(void);
+    void record(const alert_mask active, const int16_t values[]);
+    void update(void);
+    void clear(void);
+
+    uint8_t count(void);
+    bool entry(const uint8_t index, event_entry &event);
+    uint16_t dropped(void);
+
+}
+
+#endif
@@ -8,8 +8,11 @@
  * @brief Header file defining data structures and functions supporting
  *        fixed point arithmetic.
  *
+ * All operations are constexpr so that fixed point constants (e.g. default
+ * calibration gains) are folded at compile time and can live in PROGMEM.
+ *
  */
- 
+
 #ifndef _FIXED_H
 #define _FIXED_H
 
@@ -17,11 +20,27 @@ using fixed = int32_t;
 
 namespace Fixed {
 
-    fixed int2fixed(const int16_t value);
-    int16_t fixed2int(const fixed value);
+    /// Number of fractional bits in a fixed point value
+    constexpr uint8_t shift = 5;
+
+    constexpr fixed int2fixed(const int16_t value) {
+        return static_cast<fixed>(value) << shift;
+    }
+
+    /// Fixed point representation of 1
+    constexpr fixed fixed_one = int2fixed(1);
+
+    constexpr int16_t fixed2int(const fixed value) {
+        return static_cast<int16_t>(value >> shift);
+    }
+
+    constexpr fixed multiply(const fixed value1, const fixed value2) {
+        return static_cast<fixed>((static_cast<int64_t>(value1) * static_cast<int64_t>(value2)) >> shift);
+    }
 
-    fixed multiply(const fixed value1, const fixed value2);
-    fixed invert(const fixed value);
+    constexpr fixed invert(const fixed value) {
+        return static_cast<fixed>((static_cast<int64_t>(fixed_one) << shift) / static_cast<int64_t>(value));
+    }
 
 }
 
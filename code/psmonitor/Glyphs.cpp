@@ -0,0 +1,71 @@
+/**
+ * @file Glyphs.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Loads custom characters into the LCD, skipping uploads of characters already loaded.
+ *
+ * Bitmaps for all custom characters are kept in program memory. The glyph loaded in each
+ * of the LCD's 8 CGRAM slots is remembered, so a slot is only rewritten when a different
+ * glyph is requested; pages that redraw every frame can request their glyphs each time
+ * without costing LCD bandwidth.
+ *
+ * Loading a glyph leaves the LCD addressing CGRAM, so set the cursor before printing.
+ */
+
+// Include our own header file
+#include "Glyphs.h"
+
+namespace Glyphs {
+
+    // Bitmaps, indexed by GLYPH
+    const uint8_t bitmaps[][8] PROGMEM = {
+        {B00100, B00100, B11111, B00100, B00100, B00000, B11111, B00000},   // GLYPH_PLUS_MINUS
+        {B10000, B10000, B10000, B10000, B10000, B10000, B10000, B10000},   // GLYPH_BAR_1
+        {B11000, B11000, B11000, B11000, B11000, B11000, B11000, B11000},   // GLYPH_BAR_2
+        {B11100, B11100, B11100, B11100, B11100, B11100, B11100, B11100},   // GLYPH_BAR_3
+        {B11110, B11110, B11110, B11110, B11110, B11110, B11110, B11110},   // GLYPH_BAR_4
+        {B00000, B00000, B00000, B00000, B00000, B00000, B00000, B11111},   // GLYPH_LEVEL_1
+        {B00000, B00000, B00000, B00000, B00000, B00000, B11111, B11111},   // GLYPH_LEVEL_2
+        {B00000, B00000, B00000, B00000, B00000, B11111, B11111, B11111},   // GLYPH_LEVEL_3
+        {B00000, B00000, B00000, B00000, B11111, B11111, B11111, B11111},   // GLYPH_LEVEL_4
+        {B00000, B00000, B00000, B11111, B11111, B11111, B11111, B11111},   // GLYPH_LEVEL_5
+        {B00000, B00000, B11111, B11111, B11111, B11111, B11111, B11111},   // GLYPH_LEVEL_6
+        {B00000, B11111, B11111, B11111, B11111, B11111, B11111, B11111},   // GLYPH_LEVEL_7
+    };
+    static_assert(sizeof(bitmaps) / sizeof(bitmaps[0]) == GLYPH_LEVEL_7 + 1,
+                  "Bitmap table must have an entry for every GLYPH");
+
+    LiquidCrystal *lcd = nullptr;
+
+    // Glyph currently in each CGRAM slot
+    uint8_t loaded[8] = {GLYPH_NONE, GLYPH_NONE, GLYPH_NONE, GLYPH_NONE,
+                         GLYPH_NONE, GLYPH_NONE, GLYPH_NONE, GLYPH_NONE};
+
+    /**
+    * @brief Saves the LCD used for custom characters.
+    *
+    * @param display   Pointer to the LCD display object
+    */
+    void setup(LiquidCrystal *display) {
+        lcd = display;
+    }
+
+    /**
+    * @brief Loads a glyph into a CGRAM slot unless it is already there.
+    *
+    * @param slot    CGRAM slot (0 - 7); the glyph is then printed with lcd->write(slot)
+    * @param glyph   The GLYPH to load
+    */
+    void load(const uint8_t slot, const uint8_t glyph) {
+        if (loaded[slot] == glyph) {
+            return;
+        }
+        uint8_t bitmap[8];
+        memcpy_P(bitmap, bitmaps[glyph], sizeof(bitmap));
+        lcd->createChar(slot, bitmap);
+        loaded[slot] = glyph;
+    }
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+/**
+ * @file Glyphs.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for LCD custom character (CGRAM) management.
+ *
+ */
+
+#ifndef _GLYPHS_H
+#define _GLYPHS_H
+
+// Include headers for third party libraries
+#include <LiquidCrystal.h>
+
+// Custom characters available for loading into the LCD's 8 CGRAM slots
+enum GLYPH : uint8_t {
+    GLYPH_PLUS_MINUS,   // Plus/minus sign
+    GLYPH_BAR_1,        // Horizontal bar, leftmost 1 of 5 pixel columns
+    GLYPH_BAR_2,
+    GLYPH_BAR_3,
+    GLYPH_BAR_4,
+    GLYPH_LEVEL_1,      // Vertical bar, bottom 1 of 8 pixel rows
+    GLYPH_LEVEL_2,
+    GLYPH_LEVEL_3,
+    GLYPH_LEVEL_4,
+    GLYPH_LEVEL_5,
+    GLYPH_LEVEL_6,
+    GLYPH_LEVEL_7,
+    GLYPH_NONE = 0xFF,  // Slot contents unknown
+};
+
+// Character codes of built-in LCD characters useful with the glyphs
+enum GLYPH_ROM : uint8_t {
+    GLYPH_ROM_BLANK = ' ',    // All pixels off
+    GLYPH_ROM_FULL = 0xFF,    // All pixels on (full bar / level 8)
+};
+
+namespace Glyphs {
+
+    void setup(LiquidCrystal *display);
+    void load(const uint8_t slot, const uint8_t glyph);
+
+}
+
+#endif
@@ -0,0 +1,167 @@
+/**
+ * @file Histogram.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Accumulates a load profile: how the current of each supply output is distributed over time.
+ *
+ * Implements a histogram of each current, fed with every set of readings the Monitor task
+ * takes. Bins are log spaced (one per power of two, so light and heavy loads are both
+ * resolved) or linear with a power of two width. Finding the bin is a shift or a table
+ * lookup, never a division, so recording costs the same for every reading. Counters are
+ * 32 bits and saturate rather than wrap, so a profile left running for weeks stays valid.
+ *
+ * To use the histogram:
+ *      - Histogram::record() - add a set of readings
+ *      - Histogram::reset() - clear all counters
+ *      - Histogram::configure() / Histogram::scale() / Histogram::shift() - bin spacing (clears counters)
+ *      - Histogram::count() / Histogram::lowerBound() - results
+ */
+
+// Standard header files
+#include <Arduino.h>
+
+// Include our own header file
+#include "Histogram.h"
+
+// MonitorTask header to include MONITOR_* enums
+#include "MonitorTask.h"
+
+namespace Histogram {
+
+    // Counters for each current, indexed by output
+    uint32_t counts[MONITOR_OUTPUTS][HISTOGRAM_BINS] = {};
+
+    // Bin spacing
+    auto binScale = uint8_t{HISTOGRAM_LOG};
+    auto binShift = uint8_t{7};
+
+    // Number of significant bits in each value of a nibble
+    const uint8_t nibbleBits[16] PROGMEM = {0, 1, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      uint8_t bin(const int16_t value);
+
+    }
+
+    /**
+    * @brief Adds the currents of a set of readings to the histogram.
+    *
+    * @param values   Readings indexed by MONITOR_SELECT_GROUP + output
+    */
+    void record(const int16_t values[]) {
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            uint32_t &counter = counts[output][bin(values[MONITOR_CURRENT + output])];
+            if (counter != UINT32_MAX) {
+                counter++;
+            }
+        }
+    }
+
+    /**
+    * @brief Clears all counters.
+    *
+    */
+    void reset(void) {
+        memset(counts, 0, sizeof(counts));
+    }
+
+    /**
+    * @brief Sets the bin spacing and clears all counters.
+    *
+    * @param newScale   HISTOGRAM_SCALE
+    * @param newShift   Width of linear bins as a power of two (ignored for log bins)
+    *
+    * @return False if the spacing is not valid
+    */
+    bool configure(const uint8_t newScale, const uint8_t newShift) {
+        if (newScale > HISTOGRAM_LINEAR || newShift > HISTOGRAM_MAX_SHIFT) {
+            return false;
+        }
+        binScale = newScale;
+        binShift = newShift;
+        reset();
+        return true;
+    }
+
+    uint8_t scale(void) {
+        return binScale;
+    }
+
+    uint8_t shift(void) {
+        return binShift;
+    }
+
+    /**
+    * @brief Gets a counter.
+    *
+    * @param output  Output number
+    * @param index   Bin number, 0 - HISTOGRAM_BINS - 1
+    *
+    * @return Number of readings in the bin; 0 if output or bin is out of range
+    */
+    uint32_t count(const uint8_t output, const uint8_t index) {
+        if (output >= MONITOR_OUTPUTS || index >= HISTOGRAM_BINS) {
+            return 0;
+        }
+        return counts[output][index];
+    }
+
+    /**
+    * @brief Gets the lowest current counted in a bin.
+    *
+    * @param index   Bin number, 0 - HISTOGRAM_BINS - 1
+    *
+    * @return Current in milliamps
+    */
+    int16_t lowerBound(const uint8_t index) {
+        if (binScale == HISTOGRAM_LINEAR) {
+            return static_cast<int16_t>(index) << binShift;
+        }
+        return (index == 0) ? 0 : 1 << (index - 1);
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      /**
+      * @brief Finds the bin for a current.
+      *
+      * Log bins number the significant bits of the value, found a nibble at a time.
+      *
+      * @param value   Current in milliamps; negative currents count in bin 0
+      *
+      * @return Bin number, 0 - HISTOGRAM_BINS - 1
+      */
+      uint8_t bin(const int16_t value) {
+          if (value <= 0) {
+              return 0;
+          }
+          const uint16_t v = static_cast<uint16_t>(value);
+          uint16_t n;
+          if (binScale == HISTOGRAM_LINEAR) {
+              n = v >> binShift;
+          }
+          else if (v >> 12) {
+              n = 12 + pgm_read_byte(&nibbleBits[v >> 12]);
+          }
+          else if (v >> 8) {
+              n = 8 + pgm_read_byte(&nibbleBits[v >> 8]);
+          }
+          else if (v >> 4) {
+              n = 4 + pgm_read_byte(&nibbleBits[v >> 4]);
+          }
+          else {
+              n = pgm_read_byte(&nibbleBits[v]);
+          }
+          return (n < HISTOGRAM_BINS) ? n : HISTOGRAM_BINS - 1;
+      }
+
+    }
+
+}
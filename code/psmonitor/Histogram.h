@@ -0,0 +1,40 @@
+#pragma once
+/**
+ * @file Histogram.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining the load-profile histogram of current draw.
+ *
+ */
+
+#ifndef _HISTOGRAM_H
+#define _HISTOGRAM_H
+
+// Bin spacing
+enum HISTOGRAM_SCALE : uint8_t {
+    HISTOGRAM_LOG = 0,      // Bin n holds currents of 2^(n-1) to 2^n - 1 mA; bin 0 holds 0 (and below)
+    HISTOGRAM_LINEAR = 1,   // Bin n holds currents of n * 2^shift to (n + 1) * 2^shift - 1 mA
+};
+
+// Number of bins per current; the last bin also counts everything above it
+constexpr uint8_t HISTOGRAM_BINS = 14;
+
+// Largest bin width for linear bins, as a power of two
+constexpr uint8_t HISTOGRAM_MAX_SHIFT = 10;
+
+namespace Histogram {
+
+    void record(const int16_t values[]);
+    void reset(void);
+    bool configure(const uint8_t scale, const uint8_t shift);
+    uint8_t scale(void);
+    uint8_t shift(void);
+
+    uint32_t count(const uint8_t output, const uint8_t index);
+    int16_t lowerBound(const uint8_t index);
+
+}
+
+#endif
@@ -6,17 +6,55 @@
  *
  * @brief Implements a MonitorTask that reads voltage and current from INA260 sensors and displays on LCD.
  *
- * Implements a MonitorTask that measures sets of voltage and current values from the ADCs of two INA260
- * voltage/current sensors, corrects for gain and offset errors using corrections stored in EEPROM,
- * and displays both positive and negative supply voltages and currents on the LCD display.
+ * Implements a MonitorTask that measures sets of voltage and current values from the ADCs of the
+ * INA260 voltage/current sensors (one per supply output), corrects for gain and offset errors using
+ * corrections stored in EEPROM, and displays the voltage and current of each output on the LCD display.
+ *
+ * Acquisition and display are separate stages. Sets of readings are taken each time the sensors
+ * complete a conversion (as set by the averaging count and conversion time); every set is checked
+ * against the alert rules and the rail tracking limit, added to the load profile, and summed into
+ * an accumulator. The display stage runs at the (slower) task interval: it takes the mean of the
+ * sets accumulated since it last ran as the readings shown, so the display cost does not limit the
+ * sample rate.
+ *
+ * The display has several pages: the voltage and current readings, the rail tracking error, the
+ * currents as bar graphs, a sparkline of recent current history, the load profile (histogram) of
+ * the currents, the over-limit event log, and the calibration profile in use.
+ * Graphs are drawn with custom characters (see Glyphs.cpp); the history behind the sparkline
+ * and the histogram are kept whichever page is shown. Pages that show every output show
+ * MONITOR_OUTPUTS_SHOWN at a time, so with more outputs a page takes several screens (and the
+ * tracking page one screen per output tracked); nextPage() steps through the screens of a page
+ * before moving to the next page.
+ *
+ * For a fast start, setup() leaves sensors that have just powered up as they are (no reset),
+ * converting with no averaging and a 1.1ms conversion time, so a first reading is ready by the time
+ * the LCD has been initialized. setConfiguration() can defer the averaged configuration until that
+ * reading has been displayed; sensors are only written when their configuration changes.
+ *
+ * Each set of readings is taken when the scheduler next reaches the task after its conversion
+ * completes; how late each sample is (a histogram of lateness) and how many samples missed their
+ * deadline (were taken after the next sample was due) are recorded, so the uniformity of the time
+ * base can be checked at runtime.
  *
  * To use the Monitor task:
  *      - MonitorTask::setup() - setup the basic task parameters and establish connection to INA260 sensors
  *      - MonitorTask::communicationOK() - check that communication with INA260s has been established
+ *      - MonitorTask::setConfiguration() - set averaging count and conversion time together, now or once the
+ *        first reading has been displayed; optional
  *      - MonitorTask::setAveragingCount() - set number of samples taken and averaged for each measurement; optional
  *      - MonitorTask::setConversionTime() - set ADC conversion time per sample for each measurement; optional
+ *      - MonitorTask::setFastSampling() - switch sensors and I2C bus to (or back from) fastest sampling
+ *      - MonitorTask::setOverCurrentAlert() - assert the sensor ALERT pins on over-current; optional
+ *      - MonitorTask::clearOverCurrentAlert() - release latched sensor ALERT pins
  *      - MonitorTask::update() - run the monitor task; call once each time through scheduler
+ *      - MonitorTask::getSamplePeriod() - time between sets of readings
+ *      - MonitorTask::nextPage() - show the next display page
+ *      - MonitorTask::page() - display page shown (MONITOR_PAGE)
+ *      - MonitorTask::nextEvent() - show the next older event on the event log page
  *      - MonitorTask::getRawValues() - call anytime after setup to retrieve raw, unscaled and uncorrected values from sensors
+ *      - MonitorTask::readFrame() - call anytime after setup to read a set of corrected values without displaying them
+ *      - MonitorTask::getJitter(), MonitorTask::getMissedDeadlines(), MonitorTask::getMaxLateness() - sample timing
+ *      - MonitorTask::resetTiming() - clear the sample timing records
  *
  * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
  * is responsible for relinquishing control; this code is *not threadsafe* and must not be
@@ -27,6 +65,7 @@
 
 // Include standard headers as needed
 #include <Arduino.h>
+#include <Wire.h>
 
 // Include third party libraries
 #include "Adafruit_INA260.h"
@@ -37,9 +76,27 @@
 // Include other tasks that are part of this application
 #include "BuzzerTask.h"
 
+// Include startup profiling
+#include "Benchmark.h"
+
 // Include calibration support
 #include "Calibration.h"
 
+// Include LCD custom character support
+#include "Glyphs.h"
+
+// Include alert rules and over-current protection
+#include "Alerts.h"
+#include "Protection.h"
+
+// Include the load profile histogram, the over-limit event log and the rail tracking monitor
+#include "Histogram.h"
+#include "EventLog.h"
+#include "Tracking.h"
+
+// Include the snapshot of the latest readings shared with other tasks
+#include "Readings.h"
+
 // When any output exceeds the design range, beep once for every
 // OVER_RANGE_BEEP_N times the Monitor task runs.
 #define OVER_RANGE_BEEP_N 10
@@ -50,56 +107,121 @@
 // Limits on power supply output voltages and currents
 #include "limits.h"
 
-// Storage indexed to readings
-int16_t readings[4] = {};
-
 namespace MonitorTask {
 
     // Forward declarations of functions used only in this task
     namespace
     {
 
-      int16_t nearest10(int16_t value);
-      char* generateVoltageString(int16_t value);
+      void displayReadings(void);
+      void displayTracking(void);
+      void displayBarGraphs(void);
+      void displaySparklines(void);
+      void displayHistogram(void);
+      void displayEvents(void);
+      void displayProfile(void);
+      void displayLabel(const char type, const uint8_t output);
+      uint8_t screens(const uint8_t page);
+      void recordHistory(void);
+      void recordLateness(const uint32_t lateness);
+      bool acquire(void);
+      void updateSamplePeriod(void);
+      void applyStartupConfiguration(void);
 
     }
 
     bool commOKFlag = false;
     bool startedFlag = false;
     
-    // Task timing (all in milliseconds)
+    // Display timing (all in milliseconds)
     auto taskInterval = uint32_t{};
     auto rolloverThreshold = uint32_t{};  // Should be 100*taskInterval
     auto currentTime = uint32_t{};
     auto targetTime = uint32_t{0};
 
+    // Acquisition timing (all in microseconds)
+    auto samplePeriod = uint32_t{};         // Time for the sensors to convert a set of readings
+    auto sampleTarget = uint32_t{};         // Time the next set is due
+    auto samplingStarted = bool{false};
+
+    // Sensor configuration, kept to compute the sample period
+    auto averagingCount = INA260_COUNT_1;
+    auto conversionTime = INA260_TIME_1_1_ms;
+
+    // Configuration to switch to once the first reading has been displayed
+    auto startupPending = bool{false};
+    auto startupCount = INA260_COUNT_1;
+    auto startupTime = INA260_TIME_1_1_ms;
+
+    // Sensor averaging counts and conversion times in microseconds, indexed by
+    // INA260_AveragingCount and INA260_ConversionTime
+    const uint16_t averagingCounts[] PROGMEM = {1, 4, 16, 64, 128, 256, 512, 1024};
+    const uint16_t conversionTimes[] PROGMEM = {140, 204, 332, 558, 1100, 2116, 4156, 8244};
+
+    // Decimating accumulator: sum of the sets of readings since the display stage last ran
+    int32_t sums[MONITOR_VALUES] = {};
+    auto sampleCount = uint16_t{0};
+    auto alerting = bool{false};            // Any alert rule or the tracking alarm active for any set since then
+
+    // Sample timing records; counters saturate
+    uint16_t jitter[JITTER_BINS] = {};      // Samples by lateness
+    auto missedDeadlines = uint16_t{0};     // Samples a whole sample period or more late
+    auto maxLateness = uint16_t{0};         // Latest sample, in microseconds
+
+    // I2C clock for fast sampling; the INA260 and ISO1540 both support fast mode
+    constexpr uint32_t FAST_I2C_CLOCK = 400000;
+    constexpr uint32_t NORMAL_I2C_CLOCK = 100000;
+
+    // Sensor configuration saved while fast sampling
+    auto fastSampling = bool{false};
+    auto savedCount = INA260_COUNT_16;
+    auto savedTime = INA260_TIME_2_116_ms;
+
     // Buzzer management when alerting on over spec usage
     uint8_t beep_count = 0;
     
-    // Classes to manage INA260 voltage/current monitoring devices
-    Adafruit_INA260 ina260Pos = Adafruit_INA260();
-    Adafruit_INA260 ina260Neg = Adafruit_INA260();
-
-    // Alert limit flags
-    bool alert[4];
+    // Classes to manage INA260 voltage/current monitoring devices, one per output
+    Adafruit_INA260 sensors[MONITOR_OUTPUTS];
+    auto negativeOutputs = uint8_t{0};      // One bit per output (monitor_output::negative)
+    static_assert(MONITOR_OUTPUTS <= 8, "Negative outputs are kept as a bit mask");
+    char labels[MONITOR_OUTPUTS];           // monitor_output::label
 
     // Display LCD
     LiquidCrystal *lcd;
+    auto currentPage = uint8_t{PAGE_READINGS};
+    auto currentScreen = uint8_t{0};        // Screen of the page shown; outputs from currentScreen * MONITOR_OUTPUTS_SHOWN
+    auto eventShown = uint8_t{0};           // Event log entry shown; 0 for the newest
+
+    // Display geometry; graphs follow a two character label
+    constexpr uint8_t GRAPH_CELLS = 14;
+    constexpr uint8_t BAR_PIXELS = 5;       // Pixel columns per character
+    constexpr uint8_t LEVEL_PIXELS = 8;     // Pixel rows per character
+
+    // Sparkline history: one level (0 - LEVEL_PIXELS) per cell for each current, oldest first.
+    // Each cell holds the peak of SPARKLINE_RUNS task runs.
+    constexpr uint8_t SPARKLINE_RUNS = 5;
+    uint8_t history[MONITOR_OUTPUTS][GRAPH_CELLS] = {};
+    int16_t historyPeak[MONITOR_OUTPUTS] = {};
+    auto historyRuns = uint8_t{0};
+
+    // The histogram page shows one cell per bin
+    static_assert(HISTOGRAM_BINS == GRAPH_CELLS, "Histogram bins must match the graph width");
+
+    // Graph pages show one output per row
+    static_assert(MONITOR_OUTPUTS_SHOWN <= 2, "The LCD has two rows");
 
 
     /**
     * @brief Configures the Monitor task basic operating parameters and LCD display.
     *
-    * @param interval   Time in milliseconds between task runs
-    * @param pos_addr   I2C address of positive voltage/current INA260 sensor
-    * @param neg_addr   I2C address of negative voltage/current INA260 sensor
+    * @param interval   Time in milliseconds between display updates
+    * @param outputs    Sensor of each output, MONITOR_OUTPUTS entries in output order (in PROGMEM)
     * @param display    Pointer to the LCD display object
     *
     * @todo Retrieve calibration data from EEPROM
     */
     void setup(const uint32_t interval,
-               const uint8_t pos_addr,
-               const uint8_t neg_addr,
+               const monitor_output outputs[],
                LiquidCrystal *display) {
 
         // This initialization only performed once
@@ -107,14 +229,26 @@ namespace MonitorTask {
         taskInterval = interval;
         rolloverThreshold = static_cast<uint32_t>(100) * taskInterval;
 
-        // Initialize and verify communication with the ina260 devices
-        if (ina260Pos.begin(pos_addr) && ina260Neg.begin(neg_addr)) {
-            commOKFlag = true;
+        // Initialize and verify communication with the ina260 devices; sensors
+        // that have just powered up are not reset
+        commOKFlag = true;
+        negativeOutputs = 0;
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            if (!sensors[output].begin(pgm_read_byte(&outputs[output].address))) {
+                commOKFlag = false;
+            }
+            if (pgm_read_byte(&outputs[output].negative)) {
+                negativeOutputs |= 1 << output;
+            }
+            labels[output] = pgm_read_byte(&outputs[output].label);
         }
 
         // Save the display
         lcd = display;
 
+        // Sensors power up with no averaging and a 1.1ms conversion time
+        updateSamplePeriod();
+
         return;
     }
 
@@ -127,13 +261,57 @@ namespace MonitorTask {
         return commOKFlag;
     }
 
+    /**
+    * @brief Sets the number of samples to average and the conversion time, with one write to each sensor.
+    *
+    * Sensors already in the configuration are not written (writing restarts conversion).
+    *
+    * @param count      Number of samples averaged
+    * @param conv       Conversion time of each voltage and current sample
+    * @param deferred   True to keep the present configuration until the first reading has been displayed
+    */
+    void setConfiguration(INA260_AveragingCount count, INA260_ConversionTime conv, const bool deferred) {
+        if (deferred) {
+            startupCount = count;
+            startupTime = conv;
+            startupPending = true;
+            return;
+        }
+        startupPending = false;
+        auto restarted = bool{false};
+        for (auto &sensor : sensors) {
+            if (sensor.setConfig(count, conv, conv)) {
+                restarted = true;
+            }
+        }
+        averagingCount = count;
+        conversionTime = conv;
+        updateSamplePeriod();
+        if (restarted) {
+            // The next set of readings is a whole sample period away
+            samplingStarted = true;
+            sampleTarget = micros() + samplePeriod;
+        }
+    }
+
     /**
     * @brief Set the number of samples to average.
     *
     */
     void setAveragingCount(INA260_AveragingCount count) {
-        ina260Pos.setAveragingCount(count);
-        ina260Neg.setAveragingCount(count);
+        for (auto &sensor : sensors) {
+            sensor.setAveragingCount(count);
+        }
+        averagingCount = count;
+        updateSamplePeriod();
+    }
+
+    /**
+    * @brief Get the number of samples averaged.
+    *
+    */
+    INA260_AveragingCount getAveragingCount(void) {
+        return sensors[0].getAveragingCount();
     }
 
     /**
@@ -141,21 +319,89 @@ namespace MonitorTask {
     *
     */
     void setConversionTime(INA260_ConversionTime conv) {
-        ina260Pos.setVoltageConversionTime(conv);
-        ina260Pos.setCurrentConversionTime(conv);
-        ina260Neg.setVoltageConversionTime(conv);
-        ina260Neg.setCurrentConversionTime(conv);
+        for (auto &sensor : sensors) {
+            sensor.setVoltageConversionTime(conv);
+            sensor.setCurrentConversionTime(conv);
+        }
+        conversionTime = conv;
+        updateSamplePeriod();
+    }
+
+    /**
+    * @brief Get the time over which the current and bus voltage samples are measured.
+    *
+    */
+    INA260_ConversionTime getConversionTime(void) {
+        return sensors[0].getCurrentConversionTime();
+    }
+
+    /**
+    * @brief Switch the sensors and I2C bus to (or back from) the fastest sampling rate.
+    *
+    * Fast sampling uses the shortest conversion time, no averaging and a 400kHz I2C clock;
+    * the previous sensor configuration is restored when fast sampling ends.
+    *
+    * @param fast   True to start fast sampling, false to restore the previous configuration
+    */
+    void setFastSampling(const bool fast) {
+        if (fast == fastSampling) {
+            return;
+        }
+        fastSampling = fast;
+        if (fast) {
+            applyStartupConfiguration();
+            savedCount = getAveragingCount();
+            savedTime = getConversionTime();
+            setAveragingCount(INA260_COUNT_1);
+            setConversionTime(INA260_TIME_140_us);
+            Wire.setClock(FAST_I2C_CLOCK);
+        }
+        else {
+            Wire.setClock(NORMAL_I2C_CLOCK);
+            setAveragingCount(savedCount);
+            setConversionTime(savedTime);
+            samplingStarted = false;
+        }
+    }
+
+    /**
+    * @brief Set every sensor to assert its ALERT pin (active low, latched) on over-current.
+    *
+    * @param limit   Current limit in milliamps
+    */
+    void setOverCurrentAlert(const int16_t limit) {
+        for (auto &sensor : sensors) {
+            sensor.setAlertLimit(limit);
+            sensor.setAlertPolarity(INA260_ALERT_POLARITY_NORMAL);
+            sensor.setAlertLatch(INA260_ALERT_LATCH_ENABLED);
+            sensor.setAlertType(INA260_ALERT_OVERCURRENT);
+        }
+    }
+
+    /**
+    * @brief Release latched ALERT pins; reading the Mask/Enable register clears the latch.
+    *
+    */
+    void clearOverCurrentAlert(void) {
+        for (auto &sensor : sensors) {
+            (void) sensor.alertFunctionFlag();
+        }
     }
 
     /**
     * @brief Called each time through the scheduling loop to implement monitoring.
     *
-    * Implements the MonitorTask main function to display current and voltage for both
-    * positive and negative supplies. Runs whenever the scheduler transfers control to the
-    * MonitorTask and determines if it is time to run; if not time to run, immediately
-    * relinquishes control back to the scheduler.
+    * Implements the MonitorTask main function to display current and voltage for each
+    * output. Runs whenever the scheduler transfers control to the
+    * MonitorTask: takes a set of readings if the sensors have converted one, then updates
+    * the display if it is time to; otherwise immediately relinquishes control back to the
+    * scheduler.
     */
     void update() {
+        if (!acquire()) {
+            return;
+        }
+
         currentTime = millis();
         
         // Handle timer register rollover. Restarts task if rollover detected.
@@ -181,48 +427,132 @@ namespace MonitorTask {
             targetTime += taskInterval;
         }
 
-        // Process voltage readings
-        readings[MONITOR_VOLTAGE_POS] = nearest10( Calibration::correct(DATA_VOLTAGE_POS, ina260Pos.readBusVoltageInt16()) );
-        readings[MONITOR_VOLTAGE_NEG] = -nearest10( Calibration::correct(DATA_VOLTAGE_NEG, ina260Neg.readBusVoltageInt16()) );
-    
-        // Process current readings (current always treated as positive)
-        readings[MONITOR_CURRENT_POS] = Calibration::correct(DATA_CURRENT_POS, ina260Pos.readCurrentInt16());
-        readings[MONITOR_CURRENT_NEG] = Calibration::correct(DATA_CURRENT_NEG, ina260Neg.readCurrentInt16());
-
-        // Check all voltages and current against specifications (all currents are treated as positive)
-        alert[MONITOR_VOLTAGE_POS] = (readings[MONITOR_VOLTAGE_POS] > LIMIT_MAX_VOLTAGE);
-        alert[MONITOR_VOLTAGE_NEG] = (readings[MONITOR_VOLTAGE_NEG] < -LIMIT_MAX_VOLTAGE);
-        alert[MONITOR_CURRENT_POS] = (readings[MONITOR_CURRENT_POS] > LIMIT_MAX_CURRENT);
-        alert[MONITOR_CURRENT_NEG] = (readings[MONITOR_CURRENT_NEG] > LIMIT_MAX_CURRENT);
-
-        // Alert on voltage or current out of range. Beep every OVER_RANGE_BEEP_N times
-        // the Monitor task runs.
-        if (alert[MONITOR_VOLTAGE_POS] || alert[MONITOR_VOLTAGE_NEG] || alert[MONITOR_CURRENT_POS] || alert[MONITOR_CURRENT_NEG]) {
+        // Readings shown are the means of the sets accumulated since the last display update
+        int16_t means[MONITOR_VALUES];
+        for (auto value = uint8_t{0}; value < MONITOR_VALUES; value++) {
+            means[value] = static_cast<int16_t>(sums[value] / static_cast<int32_t>(sampleCount));
+            sums[value] = 0;
+        }
+        sampleCount = 0;
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            int16_t &voltage = means[MONITOR_VOLTAGE + output];
+            voltage = negative(output) ? -nearest10(-voltage) : nearest10(voltage);
+        }
+        Readings::publish(means);
+
+        // Alert on voltage or current out of range in any set. Beep every OVER_RANGE_BEEP_N
+        // times the display is updated.
+        if (alerting) {
+            alerting = false;
             if (beep_count <= 0) {
                 beep_count = OVER_RANGE_BEEP_N;
-                BuzzerTask::beep(BEEP_BLIP, 1);
+                BuzzerTask::play(PATTERN_OVER_RANGE);
             }
             else {
                 beep_count--;
             }
         }
         
-        // Display voltage data
-        lcd->setCursor(0, 0);
-        lcd->print(F("V  "));
-        lcd->print(generateVoltageString(readings[MONITOR_VOLTAGE_POS]));
-        lcd->print(" ");
-        lcd->print(generateVoltageString(readings[MONITOR_VOLTAGE_NEG]));
-
-        // Display current data (note: current is always considered positive to avoid
-        // cluttering the display).
-        lcd->setCursor(0, 1);
-        lcd->print(F("mA  "));
-        (void) sprintf(string_buf, "% 5d ", readings[MONITOR_CURRENT_POS]);
-        lcd->print(string_buf);
-        lcd->print(" ");
-        (void) sprintf(string_buf, "% 5d", readings[MONITOR_CURRENT_NEG]);
-        lcd->print(string_buf);
+        recordHistory();
+        Tracking::update();
+
+        switch (currentPage) {
+        case PAGE_TRACKING:
+            displayTracking();
+            break;
+        case PAGE_BARGRAPH:
+            displayBarGraphs();
+            break;
+        case PAGE_SPARKLINE:
+            displaySparklines();
+            break;
+        case PAGE_HISTOGRAM:
+            displayHistogram();
+            break;
+        case PAGE_EVENTS:
+            displayEvents();
+            break;
+        case PAGE_PROFILE:
+            displayProfile();
+            break;
+        case PAGE_READINGS:
+        default:
+            displayReadings();
+            break;
+        }
+
+        // Switch from the quick startup configuration once its reading is shown
+        if (startupPending) {
+            Benchmark::bootMark(BOOT_FIRST_READING);
+            applyStartupConfiguration();
+        }
+        else {
+            Benchmark::bootMark(BOOT_PRECISE_READING);
+        }
+    }
+
+    /**
+    * @brief Gets the time the sensors take to convert a set of readings.
+    *
+    * @return Sample period in microseconds
+    */
+    uint32_t getSamplePeriod(void) {
+        return samplePeriod;
+    }
+
+    /**
+    * @brief Selects the next screen of the display page, or the next page after its last screen;
+    *        shown the next time the task runs.
+    *
+    */
+    void nextPage(void) {
+        if (++currentScreen >= screens(currentPage)) {
+            currentScreen = 0;
+            do {
+                currentPage = (currentPage + 1) % PAGE_COUNT;
+            } while (screens(currentPage) == 0);
+        }
+        eventShown = 0;
+        lcd->clear();
+    }
+
+    /**
+    * @brief Gets the display page shown.
+    *
+    * @return MONITOR_PAGE
+    */
+    uint8_t page(void) {
+        return currentPage;
+    }
+
+    /**
+    * @brief Gets the character identifying an output on the display.
+    *
+    * @param output   Output number
+    *
+    * @return monitor_output::label; '?' if output is out of range
+    */
+    char label(const uint8_t output) {
+        return (output < MONITOR_OUTPUTS) ? labels[output] : '?';
+    }
+
+    /**
+    * @brief Gets whether an output is negative with respect to common (its voltages read negative).
+    *
+    * @param output   Output number
+    */
+    bool negative(const uint8_t output) {
+        return output < MONITOR_OUTPUTS && (negativeOutputs & (1 << output));
+    }
+
+    /**
+    * @brief Shows the next older event on the event log page; after the oldest, the newest.
+    *
+    */
+    void nextEvent(void) {
+        if (++eventShown >= EventLog::count()) {
+            eventShown = 0;
+        }
     }
 
     /**
@@ -232,19 +562,76 @@ namespace MonitorTask {
     *
     * This function supports the Calibrate task and is safe to call after setup but
     * when the Monitor task is not being scheduled (i.e. during calibration).
-    * Note that the global readings array is used here for raw readings, so this must not
-    * be called when the monitor task is being scheduled.
+    * The raw values are published as the latest readings, so this must not be called
+    * when the monitor task is being scheduled.
     *
-    * @param[out] readings[]   Returns results in global array
+    * Results are published with Readings::publish()
     */
     void getRawValues(void) {
-        // Process voltage readings
-        readings[MONITOR_VOLTAGE_POS] = ina260Pos.readBusVoltageRaw();
-        readings[MONITOR_VOLTAGE_NEG] = ina260Neg.readBusVoltageRaw();
-    
-        // Process current readings (current always treated as positive)
-        readings[MONITOR_CURRENT_POS] = ina260Pos.readCurrentRaw();
-        readings[MONITOR_CURRENT_NEG] = ina260Neg.readCurrentRaw();
+        int16_t raw[MONITOR_VALUES];
+
+        // Voltages are read as magnitudes; current always treated as positive
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            raw[MONITOR_VOLTAGE + output] = sensors[output].readBusVoltageRaw();
+            raw[MONITOR_CURRENT + output] = sensors[output].readCurrentRaw();
+        }
+        Readings::publish(raw);
+    }
+
+    /**
+    * @brief Reads a set of corrected voltage and current values.
+    *
+    * Unlike update(), values are not rounded or displayed and the task timing is not used;
+    * supports the measurement modes that sample as fast as the sensors allow.
+    *
+    * @param[out] frame   Returns values indexed by MONITOR_SELECT_GROUP + output (mV and mA)
+    */
+    void readFrame(int16_t frame[]) {
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            Adafruit_INA260 &sensor = sensors[output];
+            const int16_t voltage = Calibration::correct(MONITOR_VOLTAGE + output, sensor.readBusVoltageInt16());
+            frame[MONITOR_VOLTAGE + output] = (negativeOutputs & (1 << output)) ? -voltage : voltage;
+            frame[MONITOR_CURRENT + output] = Calibration::correct(MONITOR_CURRENT + output, sensor.readCurrentInt16());
+        }
+    }
+
+    /**
+    * @brief Gets the number of samples taken with a lateness in a range.
+    *
+    * @param bin   Lateness bin, 0 - JITTER_BINS - 1; the last bin includes all later samples
+    *
+    * @return Number of samples; 0 if bin is out of range
+    */
+    uint16_t getJitter(const uint8_t bin) {
+        return (bin < JITTER_BINS) ? jitter[bin] : 0;
+    }
+
+    /**
+    * @brief Gets the number of samples that missed their deadline: taken a whole sample period
+    *        or more late, i.e. after the next sample was due.
+    *
+    */
+    uint16_t getMissedDeadlines(void) {
+        return missedDeadlines;
+    }
+
+    /**
+    * @brief Gets the greatest lateness of any sample, in microseconds.
+    *
+    * @return Lateness in microseconds; saturates at 65535
+    */
+    uint16_t getMaxLateness(void) {
+        return maxLateness;
+    }
+
+    /**
+    * @brief Clears the sample timing records.
+    *
+    */
+    void resetTiming(void) {
+        memset(jitter, 0, sizeof(jitter));
+        missedDeadlines = 0;
+        maxLateness = 0;
     }
 
     // Functions used only in this task
@@ -252,41 +639,440 @@ namespace MonitorTask {
     {
 
       /**
-      * @brief Round integer to nearest multiple of 10.
+      * @brief Displays the voltage and current readings of the outputs on the screen shown.
       *
-      * @return Rounded integer
+      * Outputs are only labelled when there is more than one screen of them; otherwise the
+      * voltages' signs tell them apart.
       */
-      int16_t nearest10(int16_t value) {
-          int16_t a = (value / 10) * 10;
-          if ((value - a) >= 5) {
-              return a + 10;
+      void displayReadings(void) {
+          int16_t values[MONITOR_VALUES];
+          (void) Readings::read(values);
+          const uint8_t first = currentScreen * MONITOR_OUTPUTS_SHOWN;
+
+          // Display voltage data
+          lcd->setCursor(0, 0);
+          lcd->print('V');
+          lcd->print((MONITOR_OUTPUTS > MONITOR_OUTPUTS_SHOWN) ? labels[first] : ' ');
+          for (auto column = uint8_t{0}; column < MONITOR_OUTPUTS_SHOWN; column++) {
+              lcd->print(' ');
+              if (first + column < MONITOR_OUTPUTS) {
+                  lcd->print(generateVoltageString(values[MONITOR_VOLTAGE + first + column]));
+              }
+              else {
+                  lcd->print(F("      "));
+              }
           }
-          return a;
+
+          // Display current data (note: current is always considered positive to avoid
+          // cluttering the display).
+          lcd->setCursor(0, 1);
+          if (Protection::tripped()) {
+              lcd->print(F("TRIP"));
+          }
+          else {
+              lcd->print(F("mA  "));
+          }
+          for (auto column = uint8_t{0}; column < MONITOR_OUTPUTS_SHOWN; column++) {
+              if (column != 0) {
+                  lcd->print(F("  "));
+              }
+              if (first + column < MONITOR_OUTPUTS) {
+                  (void) sprintf(string_buf, "% 5d", values[MONITOR_CURRENT + first + column]);
+                  lcd->print(string_buf);
+              }
+              else {
+                  lcd->print(F("     "));
+              }
+          }
+      }
+
+      /**
+      * @brief Displays the tracking error of the output on the screen shown (|V0| - |Vn|, see
+      *        Tracking.cpp) and its change over the last minute.
+      *
+      * A '!' marks the tracking alarm.
+      */
+      void displayTracking(void) {
+          const uint8_t output = currentScreen + 1;
+          lcd->setCursor(0, 0);
+          (void) sprintf(string_buf, "Track%c%+6dmV %c", labels[output], Tracking::error(output),
+                         Tracking::alarm(output) ? '!' : ' ');
+          lcd->print(string_buf);
+
+          // Trend limited to what fits the display
+          int16_t trend = Tracking::trend(output);
+          if (trend > 9999) {
+              trend = 9999;
+          }
+          else if (trend < -9999) {
+              trend = -9999;
+          }
+          lcd->setCursor(0, 1);
+          (void) sprintf(string_buf, "Trend%+5dmV/min", trend);
+          lcd->print(string_buf);
       }
 
       /**
-      * @brief Generates a voltage string from the provided integer value.
+      * @brief Scales a current to a number of pixels; full scale is LIMIT_MAX_CURRENT.
       *
-      * Generate voltage string from provided value. Takes value in millivolts and presents as decimal
-      * volts with precision to hundredths of a volt.
+      * @param current   Current in milliamps; negative currents show as zero
+      * @param pixels    Number of pixels at full scale
       *
-      * @param value   Integer value of voltage in millivolts
+      * @return Number of pixels, 0 - pixels
+      */
+      uint8_t scale(const int16_t current, const uint8_t pixels) {
+          const int16_t clamped = constrain(current, int16_t{0}, static_cast<int16_t>(LIMIT_MAX_CURRENT));
+          return static_cast<uint8_t>((static_cast<int32_t>(clamped) * pixels + LIMIT_MAX_CURRENT / 2) / LIMIT_MAX_CURRENT);
+      }
+
+      /**
+      * @brief Displays the currents of the outputs on the screen shown as horizontal bar graphs.
       *
-      * @return String representing decimal volts to thousandths of a volt
       */
-      char* generateVoltageString(int16_t value) {
-          // Generate the string from integer values
-          (void) sprintf(string_buf, "%+ 5d", value / 10);
-          // Set seventh character to nul to terminate string
-          string_buf[6] = 0;
-          // Move rightmost 2 digits to the right
-          string_buf[5] = string_buf[4];
-          string_buf[4] = string_buf[3];
-          // Add decimal point
-          string_buf[3] = '.';
-          return string_buf;
+      void displayBarGraphs(void) {
+          // Partial cells use slots 1 - 4 (n pixel columns in slot n)
+          for (auto slot = uint8_t{1}; slot < BAR_PIXELS; slot++) {
+              Glyphs::load(slot, GLYPH_BAR_1 + slot - 1);
+          }
+          for (auto row = uint8_t{0}; row < MONITOR_OUTPUTS_SHOWN; row++) {
+              const uint8_t output = currentScreen * MONITOR_OUTPUTS_SHOWN + row;
+              lcd->setCursor(0, row);
+              displayLabel('I', output);
+              if (output >= MONITOR_OUTPUTS) {
+                  continue;
+              }
+              uint8_t pixels = scale(Readings::get(MONITOR_CURRENT + output), GRAPH_CELLS * BAR_PIXELS);
+              for (auto cell = uint8_t{0}; cell < GRAPH_CELLS; cell++) {
+                  if (pixels >= BAR_PIXELS) {
+                      lcd->write(GLYPH_ROM_FULL);
+                      pixels -= BAR_PIXELS;
+                  }
+                  else if (pixels > 0) {
+                      lcd->write(pixels);
+                      pixels = 0;
+                  }
+                  else {
+                      lcd->write(GLYPH_ROM_BLANK);
+                  }
+              }
+          }
+      }
+
+      /**
+      * @brief Displays the recent history of the currents of the outputs on the screen shown as sparklines.
+      *
+      */
+      void displaySparklines(void) {
+          // Levels 1 - 7 use slots 1 - 7 (n pixel rows in slot n)
+          for (auto slot = uint8_t{1}; slot < LEVEL_PIXELS; slot++) {
+              Glyphs::load(slot, GLYPH_LEVEL_1 + slot - 1);
+          }
+          for (auto row = uint8_t{0}; row < MONITOR_OUTPUTS_SHOWN; row++) {
+              const uint8_t output = currentScreen * MONITOR_OUTPUTS_SHOWN + row;
+              lcd->setCursor(0, row);
+              displayLabel('I', output);
+              if (output >= MONITOR_OUTPUTS) {
+                  continue;
+              }
+              for (auto cell = uint8_t{0}; cell < GRAPH_CELLS; cell++) {
+                  const uint8_t level = history[output][cell];
+                  if (level == 0) {
+                      lcd->write(GLYPH_ROM_BLANK);
+                  }
+                  else if (level >= LEVEL_PIXELS) {
+                      lcd->write(GLYPH_ROM_FULL);
+                  }
+                  else {
+                      lcd->write(level);
+                  }
+              }
+          }
+      }
+
+      /**
+      * @brief Displays the load profile of the currents of the outputs on the screen shown, one
+      *        cell per histogram bin.
+      *
+      * Each current's bins are scaled to its fullest bin; any bin with counts shows at
+      * least one pixel row.
+      */
+      void displayHistogram(void) {
+          // Levels 1 - 7 use slots 1 - 7 (n pixel rows in slot n)
+          for (auto slot = uint8_t{1}; slot < LEVEL_PIXELS; slot++) {
+              Glyphs::load(slot, GLYPH_LEVEL_1 + slot - 1);
+          }
+          for (auto row = uint8_t{0}; row < MONITOR_OUTPUTS_SHOWN; row++) {
+              const uint8_t output = currentScreen * MONITOR_OUTPUTS_SHOWN + row;
+              lcd->setCursor(0, row);
+              displayLabel('I', output);
+              if (output >= MONITOR_OUTPUTS) {
+                  continue;
+              }
+
+              // Reduce the counts to 8 bits so the scaling needs no long division
+              auto peak = uint32_t{0};
+              for (auto bin = uint8_t{0}; bin < HISTOGRAM_BINS; bin++) {
+                  const uint32_t count = Histogram::count(output, bin);
+                  if (count > peak) {
+                      peak = count;
+                  }
+              }
+              auto reduce = uint8_t{0};
+              while ((peak >> reduce) > 0xFF) {
+                  reduce++;
+              }
+              const uint16_t full = static_cast<uint16_t>(peak >> reduce);
+              for (auto bin = uint8_t{0}; bin < HISTOGRAM_BINS; bin++) {
+                  const uint32_t count = Histogram::count(output, bin);
+                  if (count == 0) {
+                      lcd->write(GLYPH_ROM_BLANK);
+                      continue;
+                  }
+                  const uint8_t level = (static_cast<uint16_t>(count >> reduce) * LEVEL_PIXELS + full / 2) / full;
+                  if (level >= LEVEL_PIXELS) {
+                      lcd->write(GLYPH_ROM_FULL);
+                  }
+                  else {
+                      lcd->write((level > 0) ? level : 1);
+                  }
+              }
+          }
+      }
+
+      /**
+      * @brief Displays an entry of the over-limit event log.
+      *
+      * The first line shows the entry number (1 for the newest), rule, channel and peak reading;
+      * the second, the uptime when the alert started and how long it lasted.
+      */
+      void displayEvents(void) {
+          event_entry event;
+          if (!EventLog::entry(eventShown, event)) {
+              eventShown = 0;
+              if (!EventLog::entry(eventShown, event)) {
+                  lcd->setCursor(0, 0);
+                  lcd->print(F("No events       "));
+                  lcd->setCursor(0, 1);
+                  lcd->print(F("                "));
+                  return;
+              }
+          }
+
+          const bool current = event.channel >= MONITOR_CURRENT;
+          lcd->setCursor(0, 0);
+          (void) sprintf(string_buf, "%-2u R%u %c%c%6d%s", eventShown + 1, event.rule, current ? 'I' : 'V',
+                         label(event.channel % MONITOR_OUTPUTS), event.peak, current ? "mA" : "mV");
+          lcd->print(string_buf);
+
+          // Duration in tenths of a second; at most 4194.2s
+          const uint16_t tenths = (static_cast<uint32_t>(event.duration) << EVENT_DURATION_SHIFT) / 100;
+          lcd->setCursor(0, 1);
+          (void) sprintf(string_buf, "%7lus %4u.%us", static_cast<unsigned long>(event.uptime / 1000),
+                         tenths / 10, tenths % 10);
+          lcd->print(string_buf);
+      }
+
+      /**
+      * @brief Displays the number and name of the calibration profile in use.
+      *
+      */
+      void displayProfile(void) {
+          char name[CALIBRATION_NAME_LENGTH + 1];
+          const uint8_t profile = Calibration::activeProfile();
+          lcd->setCursor(0, 0);
+          (void) sprintf(string_buf, "Cal profile %u   ", profile);
+          lcd->print(string_buf);
+          lcd->setCursor(0, 1);
+          if (Calibration::profileName(profile, name)) {
+              (void) sprintf(string_buf, "%-16s", name);
+              lcd->print(string_buf);
+          }
+          else {
+              lcd->print(F("(defaults)      "));
+          }
       }
 
+      /**
+      * @brief Labels a row of a graph page with the type of value and the output; a row with
+      *        no output is blanked.
+      *
+      * @param type     'I' or 'V'
+      * @param output   Output number; MONITOR_OUTPUTS or more for none
+      */
+      void displayLabel(const char type, const uint8_t output) {
+          if (output >= MONITOR_OUTPUTS) {
+              lcd->print(F("                "));
+              return;
+          }
+          lcd->print(type);
+          lcd->print(labels[output]);
+      }
+
+      /**
+      * @brief Gets the number of screens a display page takes.
+      *
+      * @param page   MONITOR_PAGE
+      *
+      * @return Number of screens; 0 if the page has nothing to show (tracking, with one output)
+      */
+      uint8_t screens(const uint8_t page) {
+          switch (page) {
+          case PAGE_READINGS:
+          case PAGE_BARGRAPH:
+          case PAGE_SPARKLINE:
+          case PAGE_HISTOGRAM:
+              return (MONITOR_OUTPUTS + MONITOR_OUTPUTS_SHOWN - 1) / MONITOR_OUTPUTS_SHOWN;
+          case PAGE_TRACKING:
+              return MONITOR_OUTPUTS - 1;     // Each output after the first is tracked against it
+          default:
+              return 1;
+          }
+      }
+
+      /**
+      * @brief Adds the latest currents to the sparkline history.
+      *
+      * Tracks the peak of each current over SPARKLINE_RUNS runs, then shifts the peak into
+      * the history as a level.
+      */
+      void recordHistory(void) {
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              const int16_t current = Readings::get(MONITOR_CURRENT + output);
+              if (historyRuns == 0 || current > historyPeak[output]) {
+                  historyPeak[output] = current;
+              }
+          }
+          if (++historyRuns < SPARKLINE_RUNS) {
+              return;
+          }
+          historyRuns = 0;
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              memmove(history[output], history[output] + 1, GRAPH_CELLS - 1);
+              history[output][GRAPH_CELLS - 1] = scale(historyPeak[output], LEVEL_PIXELS);
+          }
+      }
+
+      /**
+      * @brief Acquisition stage: takes a set of readings once the sensors have converted one.
+      *
+      * Checks every set against the alert rules (logging alerts as they clear) and the rail
+      * tracking limit, and adds it to the load profile and the display accumulator. If a whole sample period has been missed, the schedule restarts
+      * from now rather than reading the same conversion again.
+      *
+      * @return True if the accumulator holds at least one set
+      */
+      bool acquire(void) {
+          const uint32_t now = micros();
+          if (!samplingStarted) {
+              samplingStarted = true;
+              sampleTarget = now;
+          }
+          const uint32_t lateness = now - sampleTarget;
+          if (static_cast<int32_t>(lateness) >= 0) {
+              recordLateness(lateness);
+              sampleTarget = (lateness < samplePeriod) ? sampleTarget + samplePeriod : now + samplePeriod;
+
+              int16_t frame[MONITOR_VALUES];
+              readFrame(frame);
+              const alert_mask active = Alerts::evaluate(frame);
+              EventLog::record(active, frame);
+              if (Tracking::record(frame) || active != 0) {
+                  alerting = true;
+              }
+              Histogram::record(frame);
+              for (auto value = uint8_t{0}; value < MONITOR_VALUES; value++) {
+                  sums[value] += frame[value];
+              }
+              if (sampleCount < UINT16_MAX) {
+                  sampleCount++;
+              }
+          }
+          return sampleCount > 0;
+      }
+
+      /**
+      * @brief Computes the time the sensors take to convert a set of readings.
+      *
+      * In continuous mode the sensors convert current then voltage, each averaged over the
+      * averaging count.
+      */
+      void updateSamplePeriod(void) {
+          samplePeriod = static_cast<uint32_t>(pgm_read_word(&averagingCounts[averagingCount])) *
+                         2 * pgm_read_word(&conversionTimes[conversionTime]);
+      }
+
+      /**
+      * @brief Switches to the configuration deferred by setConfiguration(), if any.
+      *
+      */
+      void applyStartupConfiguration(void) {
+          if (startupPending) {
+              setConfiguration(startupCount, startupTime, false);
+          }
+      }
+
+      /**
+      * @brief Records the lateness of a set of readings relative to its scheduled time.
+      *
+      * Lateness bins are JITTER_UNIT microseconds wide at the bottom and double in width
+      * from there.
+      *
+      * @param lateness   Actual minus scheduled time, in microseconds
+      */
+      void recordLateness(const uint32_t lateness) {
+          const uint16_t late = (lateness < UINT16_MAX) ? lateness : UINT16_MAX;
+          auto bin = uint8_t{0};
+          while (bin < JITTER_BINS - 1 && (late >> (bin + JITTER_SHIFT)) != 0) {
+              bin++;
+          }
+          if (jitter[bin] != UINT16_MAX) {
+              jitter[bin]++;
+          }
+          if (late > maxLateness) {
+              maxLateness = late;
+          }
+          // A set taken after the next one was due has missed its deadline
+          if (lateness >= samplePeriod && missedDeadlines != UINT16_MAX) {
+              missedDeadlines++;
+          }
+      }
+
+    }
+
+    /**
+    * @brief Round integer to nearest multiple of 10.
+    *
+    * @return Rounded integer
+    */
+    int16_t nearest10(int16_t value) {
+        int16_t a = (value / 10) * 10;
+        if ((value - a) >= 5) {
+            return a + 10;
+        }
+        return a;
+    }
+
+    /**
+    * @brief Generates a voltage string from the provided integer value.
+    *
+    * Generate voltage string from provided value. Takes value in millivolts and presents as decimal
+    * volts with precision to hundredths of a volt.
+    *
+    * @param value   Integer value of voltage in millivolts
+    *
+    * @return String representing decimal volts to thousandths of a volt
+    */
+    char* generateVoltageString(int16_t value) {
+        // Generate the string from integer values
+        (void) sprintf(string_buf, "%+ 5d", value / 10);
+        // Set seventh character to nul to terminate string
+        string_buf[6] = 0;
+        // Move rightmost 2 digits to the right
+        string_buf[5] = string_buf[4];
+        string_buf[4] = string_buf[3];
+        // Add decimal point
+        string_buf[3] = '.';
+        return string_buf;
     }
 
 }
\ No newline at end of file
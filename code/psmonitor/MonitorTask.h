@@ -16,39 +16,86 @@
 #include "Adafruit_INA260.h"
 #include <LiquidCrystal.h>
 
-// Indexes into readings[] returned by Monitor task.
-enum MONITOR_SELECT_VALUE : int16_t {
-    MONITOR_VOLTAGE_POS = 0,
-    MONITOR_VOLTAGE_NEG = 1,
-    MONITOR_CURRENT_POS = 2,
-    MONITOR_CURRENT_NEG = 3,
-};
+// Supply outputs monitored, one INA260 sensor each; outputs are numbered from 0 in the order
+// given to MonitorTask::setup(). Readings, sensors, display pages and the per-output records
+// of other tasks are all sized from this.
+constexpr uint8_t MONITOR_OUTPUTS = 2;
+
+// Values in a set of readings: the voltage of each output, then the current of each
+constexpr uint8_t MONITOR_VALUES = 2 * MONITOR_OUTPUTS;
 
-// Relative indexes into readings[] grouped by measurement type
+// Indexes into a set of readings (see Readings.h) returned by Monitor task: the voltage of
+// output n is at MONITOR_VOLTAGE + n, its current at MONITOR_CURRENT + n
 enum MONITOR_SELECT_GROUP : int16_t {
     MONITOR_VOLTAGE = 0,
-    MONITOR_CURRENT = 2,
+    MONITOR_CURRENT = MONITOR_OUTPUTS,
+};
+
+// Outputs shown side by side (readings) or one per row (graphs) on a display page; pages
+// with more outputs than this are split into screens
+constexpr uint8_t MONITOR_OUTPUTS_SHOWN = 2;
+
+/// An output's sensor
+struct monitor_output {
+    uint8_t address;        // I2C address of the output's INA260
+    bool negative;          // Output is negative with respect to common; the sensor reads its magnitude
+    char label;             // Identifies the output on the display, e.g. '+'
+    uint8_t alertPin;       // Digital pin connected to the sensor's ALERT output (see Protection.cpp)
 };
 
-// Relative indexes into readings[] groups
-enum MONITOR_SELECT_SIGN : int16_t {
-    MONITOR_POS = 0,
-    MONITOR_NEG = 1,
+// Display pages, selected in turn by MonitorTask::nextPage()
+enum MONITOR_PAGE : uint8_t {
+    PAGE_READINGS,      // Voltages and currents
+    PAGE_TRACKING,      // Rail tracking error and trend
+    PAGE_BARGRAPH,      // Currents as horizontal bar graphs
+    PAGE_SPARKLINE,     // Recent history of currents
+    PAGE_HISTOGRAM,     // Load profile of currents
+    PAGE_EVENTS,        // Over-limit event log
+    PAGE_PROFILE,       // Calibration profile in use
+    PAGE_COUNT,
 };
 
+// Sample lateness bins; bin n holds lateness of 2^(n-1) to 2^n - 1 units of JITTER_UNIT
+// microseconds, bin 0 less than one unit
+constexpr uint8_t JITTER_BINS = 8;
+constexpr uint8_t JITTER_SHIFT = 8;
+constexpr uint16_t JITTER_UNIT = 1 << JITTER_SHIFT;
+
 namespace MonitorTask {
 
     void setup(const uint32_t interval,
-               const uint8_t pos_addr,
-               const uint8_t neg_addr,
+               const monitor_output outputs[],
                LiquidCrystal *display);
 
     // Normal methods
     bool communicationOK(void);
+    void setConfiguration(INA260_AveragingCount count, INA260_ConversionTime conv, const bool deferred);
     void setAveragingCount(INA260_AveragingCount count);
+    INA260_AveragingCount getAveragingCount(void);
     void setConversionTime(INA260_ConversionTime conv);
+    INA260_ConversionTime getConversionTime(void);
+    void setFastSampling(const bool fast);
+    void setOverCurrentAlert(const int16_t limit);
+    void clearOverCurrentAlert(void);
     void update(void);
+    uint32_t getSamplePeriod(void);
+    void nextPage(void);
+    uint8_t page(void);
+    char label(const uint8_t output);
+    bool negative(const uint8_t output);
+    void nextEvent(void);
     void getRawValues(void);
+    void readFrame(int16_t frame[]);
+
+    // Display formatting
+    int16_t nearest10(int16_t value);
+    char* generateVoltageString(int16_t value);
+
+    // Sample timing instrumentation
+    uint16_t getJitter(const uint8_t bin);
+    uint16_t getMissedDeadlines(void);
+    uint16_t getMaxLateness(void);
+    void resetTiming(void);
 
 }
 
@@ -0,0 +1,162 @@
+/**
+ * @file Protection.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a latched over-current trip output driven by the INA260 ALERT pins.
+ *
+ * Every INA260 sensor is set to assert their (active low, latched) ALERT pin when the
+ * current exceeds the trip limit. The ALERT lines are on analog pins used as digital inputs
+ * (port C, PCINT1); the pin change interrupt handler drives the trip output directly, so
+ * tripping does not wait for the Monitor task. The ALERT line of a negative output must be
+ * isolated (like the I2C bus) before it reaches the Arduino.
+ *
+ * The trip is latched: the output stays active until reset() is called (e.g. on a long
+ * press of the button) and the over-current condition has gone away. The sensors keep their
+ * latch across a reset of the Arduino (e.g. by the watchdog), but setting them up clears it
+ * (Adafruit_INA260::begin() resets them, and any read of Mask/Enable releases the latch), so
+ * the ALERT lines are sampled by sample() before the Monitor task sets the sensors up, and
+ * setup() trips if any was asserted then.
+ *
+ * Note that the INA260 compares the limit against each completed (averaged) current
+ * conversion, so the trip latency is set by the sensor conversion time and averaging count;
+ * the firmware adds only the interrupt response (a few microseconds).
+ *
+ * To use Protection:
+ *      - Protection::sample() - note any ALERT latched before this reset; call before MonitorTask::setup()
+ *      - Protection::setup() - configure the pins and sensors and arm the trip; call after MonitorTask::setup()
+ *      - Protection::tripped() - check whether the trip output is active
+ *      - Protection::reset() - attempt to reset the trip
+ */
+
+// Include our own header file
+#include "Protection.h"
+
+// Include the Monitor task that owns the sensors
+#include "MonitorTask.h"
+
+namespace Protection {
+
+    volatile uint8_t *tripPort = nullptr;
+    auto tripMask = uint8_t{};
+    volatile uint8_t *alertPort = nullptr;
+    auto alertMask = uint8_t{};
+    volatile bool trippedFlag = false;
+    auto latchedAtStart = bool{false};    // An ALERT line was asserted when sample() was called
+
+    /**
+    * @brief Samples the ALERT lines before the sensors are set up, which releases their latch.
+    *
+    * @param outputs   Sensor of each output, MONITOR_OUTPUTS entries (in PROGMEM); their alertPin is used
+    */
+    void sample(const monitor_output outputs[]) {
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            pinMode(pgm_read_byte(&outputs[output].alertPin), INPUT_PULLUP);
+        }
+        // Let the pull-ups charge the lines
+        delayMicroseconds(10);
+        latchedAtStart = false;
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            if (digitalRead(pgm_read_byte(&outputs[output].alertPin)) == LOW) {
+                latchedAtStart = true;
+            }
+        }
+    }
+
+    /**
+    * @brief Configures the trip output, the ALERT inputs and the sensors, and arms the trip.
+    *
+    * The ALERT pins of all outputs must be on the port whose pin change interrupt is handled
+    * (port C: A0 - A5, PCINT1); if any is not, nothing but the trip output is set up.
+    *
+    * @param trip_pin        Digital pin driving the relay or crowbar; HIGH when tripped
+    * @param outputs         Sensor of each output, MONITOR_OUTPUTS entries (in PROGMEM); their alertPin is used
+    * @param limit           Trip current in milliamps
+    *
+    * @return False if an ALERT pin is not on port C; the trip is not armed
+    */
+    bool setup(const uint8_t trip_pin,
+               const monitor_output outputs[],
+               const int16_t limit) {
+
+        digitalWrite(trip_pin, LOW);
+        pinMode(trip_pin, OUTPUT);
+        tripPort = portOutputRegister(digitalPinToPort(trip_pin));
+        tripMask = digitalPinToBitMask(trip_pin);
+
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            const uint8_t alert_pin = pgm_read_byte(&outputs[output].alertPin);
+            if (digitalPinToPCICR(alert_pin) == nullptr || digitalPinToPCICRbit(alert_pin) != PCIE1) {
+                return false;
+            }
+        }
+
+        const uint8_t first_pin = pgm_read_byte(&outputs[0].alertPin);
+        alertPort = portInputRegister(digitalPinToPort(first_pin));
+        alertMask = 0;
+        auto pcmsk = uint8_t{0};
+        for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+            const uint8_t alert_pin = pgm_read_byte(&outputs[output].alertPin);
+            pinMode(alert_pin, INPUT_PULLUP);
+            alertMask |= digitalPinToBitMask(alert_pin);
+            pcmsk |= bit(digitalPinToPCMSKbit(alert_pin));
+        }
+
+        MonitorTask::setOverCurrentAlert(limit);
+
+        *digitalPinToPCMSK(first_pin) |= pcmsk;
+        *digitalPinToPCICR(first_pin) |= bit(digitalPinToPCICRbit(first_pin));
+
+        // An ALERT latched before this reset was released when the sensors were set up, and
+        // one asserted since raises no pin change, so check both once now the trip is armed
+        noInterrupts();
+        if (latchedAtStart || (*alertPort & alertMask) != alertMask) {
+            *tripPort |= tripMask;
+            trippedFlag = true;
+        }
+        interrupts();
+        return true;
+    }
+
+    /**
+    * @brief Gets the state of the trip.
+    *
+    * @return True if the trip output is active
+    */
+    bool tripped(void) {
+        return trippedFlag;
+    }
+
+    /**
+    * @brief Attempts to reset the trip.
+    *
+    * Clears the latched sensor alerts and, if neither ALERT line is still asserted,
+    * releases the trip output.
+    *
+    * @return True if the trip is no longer active
+    */
+    bool reset(void) {
+        MonitorTask::clearOverCurrentAlert();
+        noInterrupts();
+        if ((*alertPort & alertMask) == alertMask) {
+            *tripPort &= ~tripMask;
+            trippedFlag = false;
+        }
+        interrupts();
+        return !trippedFlag;
+    }
+
+}
+
+/**
+* @brief Pin change interrupt handler for the ALERT lines; trips on any asserted (low) line.
+*
+*/
+ISR(PCINT1_vect) {
+    using namespace Protection;
+    if ((*alertPort & alertMask) != alertMask) {
+        *tripPort |= tripMask;
+        trippedFlag = true;
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+/**
+ * @file Protection.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for over-current protection (fast trip) support.
+ *
+ */
+
+#ifndef _PROTECTION_H
+#define _PROTECTION_H
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// monitor_output
+#include "MonitorTask.h"
+
+namespace Protection {
+
+    void sample(const monitor_output outputs[]);
+    bool setup(const uint8_t trip_pin,
+               const monitor_output outputs[],
+               const int16_t limit);
+    bool tripped(void);
+    bool reset(void);
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * @file Readings.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Keeps the latest set of readings where any task (or interrupt) can read it consistently.
+ *
+ * The latest set of voltage and current readings is published by whichever task owns the sensors
+ * (the Monitor task in normal mode, the Calibrate task through MonitorTask::getRawValues()) and
+ * read by the others. A reader must never see a set that is partly old and partly new, even if
+ * the producer runs from an interrupt part way through the read.
+ *
+ * The snapshot is double buffered with a generation counter. publish() writes the new set into
+ * the buffer not in use, then increments the generation: a single byte store, so it is atomic
+ * on the AVR, and the low bit of the generation selects the buffer readers copy. A reader notes
+ * the generation, copies the buffer it selects, and checks that the generation is unchanged; if
+ * it changed, the producer may have started overwriting that buffer (it takes two publishes to
+ * get back to it), so the read is retried. Neither side disables interrupts or waits for the
+ * other, and the producer is never delayed by readers.
+ *
+ * There must be only one producer at a time.
+ *
+ * To use the readings snapshot:
+ *      - Readings::publish() - make a new set of readings the latest
+ *      - Readings::read() - copy the latest set
+ *      - Readings::get() - get one value of the latest set
+ *      - Readings::generation() - count of sets published (modulo 256), to tell whether there is a new set
+ */
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// Include our own header file
+#include "Readings.h"
+
+// MonitorTask header to include MONITOR_* enums
+#include "MonitorTask.h"
+
+namespace Readings {
+
+    // Volatile so that the compiler keeps every copy between the reads of the generation
+    volatile int16_t buffers[2][MONITOR_VALUES] = {};
+
+    // Sets published, modulo 256; the low bit selects the buffer holding the latest set
+    volatile uint8_t publishedCount = 0;
+
+    /**
+    * @brief Makes a set of readings the latest.
+    *
+    * @param values   Array of readings indexed by MONITOR_SELECT_GROUP + output
+    */
+    void publish(const int16_t values[]) {
+        const uint8_t next = publishedCount + 1;
+        volatile int16_t *buffer = buffers[next & 1];
+        for (auto value = uint8_t{0}; value < MONITOR_VALUES; value++) {
+            buffer[value] = values[value];
+        }
+        publishedCount = next;
+    }
+
+    /**
+    * @brief Copies the latest set of readings.
+    *
+    * @param[out] values   Returns the readings indexed by MONITOR_SELECT_GROUP + output
+    *
+    * @return Generation of the set copied
+    */
+    uint8_t read(int16_t values[]) {
+        uint8_t count;
+        do {
+            count = publishedCount;
+            const volatile int16_t *buffer = buffers[count & 1];
+            for (auto value = uint8_t{0}; value < MONITOR_VALUES; value++) {
+                values[value] = buffer[value];
+            }
+        } while (publishedCount != count);
+        return count;
+    }
+
+    /**
+    * @brief Gets one value of the latest set of readings.
+    *
+    * @param value   MONITOR_SELECT_GROUP + output
+    *
+    * @return Reading in mV or mA (raw ADC counts during calibration)
+    */
+    int16_t get(const uint8_t value) {
+        uint8_t count;
+        int16_t reading;
+        do {
+            count = publishedCount;
+            reading = buffers[count & 1][value];
+        } while (publishedCount != count);
+        return reading;
+    }
+
+    /**
+    * @brief Gets the generation of the latest set of readings.
+    *
+    * @return Sets published since startup, modulo 256
+    */
+    uint8_t generation(void) {
+        return publishedCount;
+    }
+
+}
@@ -0,0 +1,24 @@
+#pragma once
+/**
+ * @file Readings.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for the shared snapshot of the latest readings.
+ *
+ */
+
+#ifndef _READINGS_H
+#define _READINGS_H
+
+namespace Readings {
+
+    void publish(const int16_t values[]);
+    uint8_t read(int16_t values[]);
+    int16_t get(const uint8_t value);
+    uint8_t generation(void);
+
+}
+
+#endif
@@ -0,0 +1,246 @@
+/**
+ * @file RippleTask.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a RippleTask that measures ripple and noise on each supply output.
+ *
+ * Implements a RippleTask that switches the INA260 sensors to their fastest conversion time
+ * with no averaging, reads voltages and currents as fast as the I2C bus allows, and computes
+ * the peak to peak and RMS deviation of each over a window of RIPPLE_WINDOW sample sets,
+ * using integer arithmetic only. Results are displayed on the LCD, MONITOR_OUTPUTS_SHOWN
+ * outputs at a time (the voltages of each group of outputs, then their currents, selected in
+ * turn with nextPage()); the sample rate achieved is measured over each window.
+ *
+ * To use the Ripple task:
+ *      - RippleTask::setup() - setup the task
+ *      - RippleTask::start() - reconfigure the sensors for fast sampling; call when entering ripple mode
+ *      - RippleTask::stop() - restore the sensor configuration; call when leaving ripple mode
+ *      - RippleTask::update() - run the ripple measurement; call once each time through scheduler
+ *      - RippleTask::nextPage() - switch the display to the next outputs, or between voltages and currents
+ *      - RippleTask::peakToPeak(), RippleTask::rms(), RippleTask::sampleRate() - results of the last window
+ *
+ * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
+ * is responsible for relinquishing control; this code is *not threadsafe* and must not be
+ * interrupted.
+ */
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// Include our own header file
+#include "RippleTask.h"
+
+// Include the Monitor task that owns the sensors
+#include "MonitorTask.h"
+
+// External storage shared between tasks
+#include "globals.h"
+
+namespace RippleTask {
+
+    // Sample sets per result, and sample sets read each time the task runs (bounds run time)
+    constexpr uint16_t RIPPLE_WINDOW = 256;
+    constexpr uint8_t RIPPLE_BURST = 8;
+
+    LiquidCrystal *lcd = nullptr;
+    auto showCurrents = bool{false};
+    auto firstShown = uint8_t{0};      // Output on the top row
+
+    // Running statistics for the window in progress. Deviations are taken from the first
+    // sample of the window so the sums stay small.
+    struct statistics {
+        int16_t reference;
+        int16_t minimum;
+        int16_t maximum;
+        int32_t sum;
+        uint64_t sumSquares;
+    };
+    statistics stats[MONITOR_VALUES];
+    auto samples = uint16_t{0};
+    auto windowStart = uint32_t{};
+
+    // Results of the last completed window
+    int16_t resultPeakToPeak[MONITOR_VALUES] = {};
+    int16_t resultRMS[MONITOR_VALUES] = {};
+    auto resultRate = uint16_t{0};
+
+    // Forward declarations of functions used only in this task
+    namespace
+    {
+
+      uint16_t squareRoot(uint32_t value);
+      void finishWindow(void);
+      void display(void);
+
+    }
+
+    /**
+    * @brief Configures the ripple task LCD display.
+    *
+    * @param display   Pointer to the LCD display object
+    */
+    void setup(LiquidCrystal *display) {
+        lcd = display;
+    }
+
+    /**
+    * @brief Reconfigures the sensors and I2C bus for fast sampling and starts a new window.
+    *
+    */
+    void start(void) {
+        MonitorTask::setFastSampling(true);
+        samples = 0;
+        lcd->setCursor(0, 0);
+        lcd->print(F("Ripple..."));
+    }
+
+    /**
+    * @brief Restores the sensor and I2C bus configuration in use before start().
+    *
+    */
+    void stop(void) {
+        MonitorTask::setFastSampling(false);
+    }
+
+    /**
+    * @brief Called each time through the scheduling loop to measure ripple.
+    *
+    * Reads RIPPLE_BURST sample sets and adds them to the statistics; once RIPPLE_WINDOW sets
+    * have been read, computes and displays the results and starts a new window.
+    */
+    void update(void) {
+        int16_t frame[MONITOR_VALUES];
+        for (auto n = uint8_t{0}; n < RIPPLE_BURST; n++) {
+            MonitorTask::readFrame(frame);
+            if (samples == 0) {
+                windowStart = micros();
+                for (auto channel = uint8_t{0}; channel < MONITOR_VALUES; channel++) {
+                    stats[channel] = {frame[channel], frame[channel], frame[channel], 0, 0};
+                }
+            }
+            for (auto channel = uint8_t{0}; channel < MONITOR_VALUES; channel++) {
+                statistics &s = stats[channel];
+                const int16_t value = frame[channel];
+                const int32_t deviation = static_cast<int32_t>(value) - s.reference;
+                if (value < s.minimum) {
+                    s.minimum = value;
+                }
+                if (value > s.maximum) {
+                    s.maximum = value;
+                }
+                s.sum += deviation;
+                s.sumSquares += static_cast<uint32_t>(deviation * deviation);
+            }
+            if (++samples == RIPPLE_WINDOW) {
+                finishWindow();
+                display();
+                samples = 0;
+                return;
+            }
+        }
+    }
+
+    /**
+    * @brief Switches the display to the next outputs; after the last, between voltage and
+    *        current results.
+    *
+    */
+    void nextPage(void) {
+        firstShown += MONITOR_OUTPUTS_SHOWN;
+        if (firstShown >= MONITOR_OUTPUTS) {
+            firstShown = 0;
+            showCurrents = !showCurrents;
+        }
+        display();
+    }
+
+    int16_t peakToPeak(const uint8_t channel) {
+        return resultPeakToPeak[channel];
+    }
+
+    int16_t rms(const uint8_t channel) {
+        return resultRMS[channel];
+    }
+
+    /**
+    * @brief Gets the sample rate achieved in the last window.
+    *
+    * @return Sample sets (all four channels) per second
+    */
+    uint16_t sampleRate(void) {
+        return resultRate;
+    }
+
+    // Functions used only in this task
+    namespace
+    {
+
+      /**
+      * @brief Integer square root (bit by bit).
+      *
+      * @return Largest integer whose square does not exceed value
+      */
+      uint16_t squareRoot(uint32_t value) {
+          auto root = uint32_t{0};
+          auto place = uint32_t{1} << 30;
+          while (place > value) {
+              place >>= 2;
+          }
+          while (place != 0) {
+              if (value >= root + place) {
+                  value -= root + place;
+                  root = (root >> 1) + place;
+              }
+              else {
+                  root >>= 1;
+              }
+              place >>= 2;
+          }
+          return static_cast<uint16_t>(root);
+      }
+
+      /**
+      * @brief Computes the results of the completed window.
+      *
+      * RMS deviation is sqrt(mean of squared deviations - squared mean deviation).
+      */
+      void finishWindow(void) {
+          const uint32_t elapsed = micros() - windowStart;
+          resultRate = static_cast<uint16_t>((static_cast<uint32_t>(RIPPLE_WINDOW) * 1000000UL) / (elapsed | 1));
+          for (auto channel = uint8_t{0}; channel < MONITOR_VALUES; channel++) {
+              const statistics &s = stats[channel];
+              const int32_t mean = s.sum / static_cast<int32_t>(RIPPLE_WINDOW);
+              const uint64_t meanSquare = s.sumSquares / RIPPLE_WINDOW;
+              const uint64_t squaredMean = static_cast<uint64_t>(static_cast<int64_t>(mean) * mean);
+              const uint64_t variance = (meanSquare > squaredMean) ? meanSquare - squaredMean : 0;
+              resultPeakToPeak[channel] = s.maximum - s.minimum;
+              resultRMS[channel] = squareRoot((variance > 0xFFFFFFFFULL) ? 0xFFFFFFFFUL : static_cast<uint32_t>(variance));
+          }
+      }
+
+      /**
+      * @brief Displays peak to peak and RMS results.
+      *
+      * One row per output: e.g. "V+ pp   24 r   6" (mV or mA).
+      */
+      void display(void) {
+          const uint8_t group = showCurrents ? MONITOR_CURRENT : MONITOR_VOLTAGE;
+          for (auto row = uint8_t{0}; row < MONITOR_OUTPUTS_SHOWN; row++) {
+              const uint8_t output = firstShown + row;
+              lcd->setCursor(0, row);
+              if (output >= MONITOR_OUTPUTS) {
+                  lcd->print(F("                "));
+                  continue;
+              }
+              lcd->print(showCurrents ? 'I' : 'V');
+              lcd->print(MonitorTask::label(output));
+              (void) sprintf(string_buf, " pp%5d r%4d", resultPeakToPeak[group + output], resultRMS[group + output]);
+              lcd->print(string_buf);
+          }
+      }
+
+    }
+
+}
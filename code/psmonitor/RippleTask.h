@@ -0,0 +1,33 @@
+#pragma once
+/**
+ * @file RippleTask.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for RippleTask.
+ *
+ */
+
+#ifndef _RIPPLETASK_H
+#define _RIPPLETASK_H
+
+// Include headers for third party libraries
+#include <LiquidCrystal.h>
+
+namespace RippleTask {
+
+    void setup(LiquidCrystal *display);
+    void start(void);
+    void stop(void);
+    void update(void);
+    void nextPage(void);
+
+    // Results of the last completed window, indexed by MONITOR_SELECT_GROUP + output (mV and mA)
+    int16_t peakToPeak(const uint8_t channel);
+    int16_t rms(const uint8_t channel);
+    uint16_t sampleRate(void);
+
+}
+
+#endif
@@ -0,0 +1,1133 @@
+/**
+ * @file SerialTask.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a SerialTask that accepts SCPI style commands and queries over the serial port.
+ *
+ * Implements a SerialTask that collects characters from the serial port into a fixed line
+ * buffer and executes each complete line as a command. Commands are looked up in a table in
+ * program memory (case insensitive); the command header is separated from any arguments by
+ * a space, and queries end in '?'. Commands:
+ *      - *IDN? - identify the instrument
+ *      - MEAS:VOLT? n, MEAS:CURR? n - latest reading of output n (mV or mA); outputs are numbered
+ *        from 0 in the order given to MonitorTask::setup()
+ *      - MEAS:VOLT:POS?, MEAS:VOLT:NEG?, MEAS:CURR:POS?, MEAS:CURR:NEG? - latest reading of output 0
+ *        (positive) or 1 (negative); kept for hosts written for the two output monitor
+ *      - MEAS:ALL? - latest readings: the voltage of each output, then the current of each
+ *      - CONF:AVER n, CONF:AVER? - sensor averaging count (1, 4, 16, 64, 128, 256, 512 or 1024)
+ *      - CONF:RULE n,channel,type,threshold,hysteresis,duration - replace alert rule n
+ *        (channel: voltage of output n is n, its current n + MONITOR_OUTPUTS; type: ALERT_TYPE; see Alerts.h)
+ *      - CONF:RULE? n - report alert rule n in the same format; CONF:RULE? reports all rules
+ *      - CONF:RULE:SAVE - store the alert rules in EEPROM
+ *      - MEAS:TRAC? - one line per output tracked against output 0, from output 1: tracking error |V0| - |Vn| (mV),
+ *        its change over the last minute (mV), alarm (1 if raised)
+ *      - CONF:TRAC limit,hysteresis, CONF:TRAC? - tracking alarm limit and hysteresis (mV; limit 0 for no
+ *        alarm); stored in EEPROM
+ *      - SYST:MUTE ON|OFF, SYST:MUTE? - buzzer muting
+ *      - PROT:TRIP? - over-current trip state; PROT:RES - reset the trip
+ *      - CAL:STAT? - 1 if calibration data from EEPROM is in use
+ *      - CAL:SAMP n, CAL:SAMP? - sets of raw values averaged for each calibration point
+ *      - CAL:PROF n, CAL:PROF? - calibration profile in use; CAL:PROF:LIST? - one line per profile: number, name
+ *        (empty if not valid); CAL:PROF:SAVE n,name - store the corrections in use as profile n
+ *      - SYST:MODE NORM|RIPP|CAPT|STEP, SYST:MODE? - measurement mode (normal, ripple, capture or load step)
+ *      - MEAS:RIPP? - last ripple results, in the order of MEAS:ALL?: peak to peak; RMS;
+ *        sample sets per second (one line each)
+ *      - CONF:TRIG channel,level,slope,pretrigger, CONF:TRIG? - capture trigger
+ *        (channel as for CONF:RULE, slope: CAPTURE_SLOPE; see CaptureTask.h)
+ *      - CAPT:ARM - discard the capture and re-arm; CAPT:STAT? - CAPTURE_STATE and microseconds per sample set
+ *      - CAPT:DATA? - completed capture, one line per sample set: index relative to the trigger, then the
+ *        readings in the order of MEAS:ALL?
+ *      - CONF:STEP threshold,band, CONF:STEP? - load step threshold (mA) and settling band (mV)
+ *      - STEP:DATA? - last load step on each output, one line each: steps analysed, step (mA), droop (mV), overshoot (mV),
+ *        settling time (us; -1 if not settled)
+ *      - CONF:HIST LOG|LIN,n, CONF:HIST? - load profile bins: log spaced, or linear 2^n mA wide (clears the profile)
+ *      - HIST:DATA? - load profile, one line per bin: lowest current in the bin, then the count of each output
+ *      - HIST:RES - clear the load profile
+ *      - LOG:DATA? - over-limit event log, one line per event, newest first: sequence number, uptime at the
+ *        start (ms), rule, channel, peak reading, duration (ms); an empty line if the log is empty
+ *      - LOG:COUN? - events in the log, events dropped; LOG:CLR - erase the log
+ *      - DIAG:JITT? - sample lateness, one line per bin: least lateness in the bin (us), count
+ *      - DIAG:LATE? - samples that missed their deadline, greatest lateness (us)
+ *      - DIAG:LOOP? - CPU cycles per scheduler loop pass, one line per mode: mode, mean, maximum
+ *      - DIAG:RES - clear the sample timing and loop statistics
+ *      - DIAG:BENCH? - run the benchmarks, one line each: name, CPU cycles per call
+ *      - DIAG:BOOT? - startup profile, one line per phase: phase, time it ended (us; 0 if not reached)
+ *      - DIAG:RST? - cause of the last reset, task stalled at the last watchdog timeout
+ *      - DIAG:RST:COUN? - resets by cause, one line each: cause, count
+ *      - DIAG:OVER? - task budget overruns, one line per task: task, count
+ *
+ * Commands reply with the requested value or "OK", or "ERR" if the command is not understood.
+ *
+ * The task never waits on the serial port: each run takes at most CHARS_PER_UPDATE received
+ * characters, and a complete command is only executed once the transmit buffer has room for
+ * a full reply line. Replies longer than one line are sent a line per run by a continuation.
+ * Commands that store settings in EEPROM queue the write with EepromWriter and reply "OK" once
+ * it is complete; no further command is executed until then.
+ *
+ * To use the Serial task:
+ *      - SerialTask::setup() - open the serial port
+ *      - SerialTask::update() - process received characters; call once each time through scheduler
+ *
+ * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
+ * is responsible for relinquishing control; this code is *not threadsafe* and must not be
+ * interrupted.
+ */
+
+// Include our own header file
+#include "SerialTask.h"
+
+// Include other tasks and utilities that commands are dispatched to
+#include "Alerts.h"
+#include "Benchmark.h"
+#include "BuzzerTask.h"
+#include "Calibration.h"
+#include "CalibrateTask.h"
+#include "MonitorTask.h"
+#include "Protection.h"
+#include "RippleTask.h"
+#include "Watchdog.h"
+#include "CaptureTask.h"
+#include "StepTask.h"
+#include "Histogram.h"
+#include "EventLog.h"
+#include "Tracking.h"
+#include "Readings.h"
+#include "EepromWriter.h"
+
+// External storage shared between tasks
+#include "globals.h"
+
+namespace SerialTask {
+
+    // Maximum number of characters taken from the serial port each time the task runs
+    constexpr uint8_t CHARS_PER_UPDATE = 8;
+
+    // Widest printed reading (int16_t), count (uint32_t) and line ending, in characters
+    constexpr uint8_t READING_WIDTH = sizeof("-32768") - 1;
+    constexpr uint8_t COUNT_WIDTH = sizeof("4294967295") - 1;
+    constexpr uint8_t EOL_WIDTH = 2;
+
+    constexpr uint8_t widest(const uint8_t a, const uint8_t b) {
+        return (a > b) ? a : b;
+    }
+
+    // Longest reply lines whose width depends on the number of outputs:
+    // MEAS:ALL? and MEAS:RIPP? (every reading), CAPT:DATA? (index, then every reading)
+    // and HIST:DATA? (bound, then the count of each output)
+    constexpr uint8_t ALL_REPLY_MAX = MONITOR_VALUES * (READING_WIDTH + 1) - 1 + EOL_WIDTH;
+    constexpr uint8_t CAPTURE_REPLY_MAX = READING_WIDTH + MONITOR_VALUES * (1 + READING_WIDTH) + EOL_WIDTH;
+    constexpr uint8_t HISTOGRAM_REPLY_MAX = READING_WIDTH + MONITOR_OUTPUTS * (1 + COUNT_WIDTH) + EOL_WIDTH;
+    // Longest fixed width line: LOG:DATA? (sequence, uptime, rule, channel, peak, duration)
+    constexpr uint8_t EVENT_REPLY_MAX = sizeof("65535,4294967295,255,255,-32768,4294967295") - 1 + EOL_WIDTH;
+
+    // Transmit buffer space needed before a command (or a continuation line) runs
+    constexpr uint8_t REPLY_MAX = widest(widest(ALL_REPLY_MAX, CAPTURE_REPLY_MAX),
+                                         widest(HISTOGRAM_REPLY_MAX, EVENT_REPLY_MAX));
+    // The ring buffer holds one character less than its size
+    static_assert(REPLY_MAX < SERIAL_TX_BUFFER_SIZE, "A reply line must fit the serial transmit buffer");
+
+    // Longest valid command: every argument of the command with the most at its widest
+    constexpr uint8_t LINE_MAX = sizeof("CONF:RULE 99,99,2,-32768,-32768,-32768") - 1;
+
+    // Received line; a line longer than the buffer is rejected, not executed in part
+    char line[40];
+    static_assert(sizeof(line) > LINE_MAX, "The line buffer must hold the longest command");
+    auto lineLength = uint8_t{0};
+    auto lineReady = bool{false};
+    auto lineOverflow = bool{false};      // Characters of the line were discarded
+
+    // Sends line n of a multi-line reply; returns false when the reply is complete
+    using continuation = bool (*)(const uint8_t line);
+    continuation pending = nullptr;
+    auto pendingLine = uint8_t{0};
+
+    /// Entry in the command table
+    struct command {
+        const char *name;               // Command header, in program memory
+        void (*handler)(char *args);    // Called with the arguments (empty string if none)
+    };
+
+    // Forward declarations of functions used only in this task
+    namespace
+    {
+
+      void execute(char *text);
+      bool parseIntegers(char *text, int16_t values[], const uint8_t count);
+      void reply(const int16_t value);
+      void ok(void);
+      void error(void);
+      bool finishWrite(const uint8_t line);
+
+      void identify(char *args);
+      void measureVoltage(char *args);
+      void measureCurrent(char *args);
+      void measureVoltagePos(char *args);
+      void measureVoltageNeg(char *args);
+      void measureCurrentPos(char *args);
+      void measureCurrentNeg(char *args);
+      void measureAll(char *args);
+      void setAveraging(char *args);
+      void getAveraging(char *args);
+      void setRule(char *args);
+      void getRule(char *args);
+      void saveRules(char *args);
+      void measureTracking(char *args);
+      void setTracking(char *args);
+      void getTracking(char *args);
+      void setMute(char *args);
+      void getMute(char *args);
+      void getTrip(char *args);
+      void resetTrip(char *args);
+      void getCalibrated(char *args);
+      void setCalibrationSamples(char *args);
+      void getCalibrationSamples(char *args);
+      void setProfile(char *args);
+      void getProfile(char *args);
+      void listProfiles(char *args);
+      void saveProfile(char *args);
+      void setMode(char *args);
+      void getMode(char *args);
+      void measureRipple(char *args);
+      void setTrigger(char *args);
+      void getTrigger(char *args);
+      void armCapture(char *args);
+      void getCaptureState(char *args);
+      void getCaptureData(char *args);
+      void setStep(char *args);
+      void getStep(char *args);
+      void getStepData(char *args);
+      void setHistogram(char *args);
+      void getHistogram(char *args);
+      void getHistogramData(char *args);
+      void resetHistogram(char *args);
+      void getEvents(char *args);
+      void getEventCount(char *args);
+      void clearEvents(char *args);
+      void getJitter(char *args);
+      void getLateness(char *args);
+      void resetTiming(char *args);
+      void runBenchmarks(char *args);
+      void getLoopCycles(char *args);
+      void getBootTimes(char *args);
+      void getResetCause(char *args);
+      void getResetCounts(char *args);
+      void getOverruns(char *args);
+
+      // Command headers
+      const char cmdIdentify[] PROGMEM = "*IDN?";
+      const char cmdMeasureVoltage[] PROGMEM = "MEAS:VOLT?";
+      const char cmdMeasureCurrent[] PROGMEM = "MEAS:CURR?";
+      const char cmdMeasureVoltagePos[] PROGMEM = "MEAS:VOLT:POS?";
+      const char cmdMeasureVoltageNeg[] PROGMEM = "MEAS:VOLT:NEG?";
+      const char cmdMeasureCurrentPos[] PROGMEM = "MEAS:CURR:POS?";
+      const char cmdMeasureCurrentNeg[] PROGMEM = "MEAS:CURR:NEG?";
+      const char cmdMeasureAll[] PROGMEM = "MEAS:ALL?";
+      const char cmdSetAveraging[] PROGMEM = "CONF:AVER";
+      const char cmdGetAveraging[] PROGMEM = "CONF:AVER?";
+      const char cmdSetRule[] PROGMEM = "CONF:RULE";
+      const char cmdGetRule[] PROGMEM = "CONF:RULE?";
+      const char cmdSaveRules[] PROGMEM = "CONF:RULE:SAVE";
+      const char cmdMeasureTracking[] PROGMEM = "MEAS:TRAC?";
+      const char cmdSetTracking[] PROGMEM = "CONF:TRAC";
+      const char cmdGetTracking[] PROGMEM = "CONF:TRAC?";
+      const char cmdSetMute[] PROGMEM = "SYST:MUTE";
+      const char cmdGetMute[] PROGMEM = "SYST:MUTE?";
+      const char cmdGetTrip[] PROGMEM = "PROT:TRIP?";
+      const char cmdResetTrip[] PROGMEM = "PROT:RES";
+      const char cmdGetCalibrated[] PROGMEM = "CAL:STAT?";
+      const char cmdSetCalibrationSamples[] PROGMEM = "CAL:SAMP";
+      const char cmdGetCalibrationSamples[] PROGMEM = "CAL:SAMP?";
+      const char cmdSetProfile[] PROGMEM = "CAL:PROF";
+      const char cmdGetProfile[] PROGMEM = "CAL:PROF?";
+      const char cmdListProfiles[] PROGMEM = "CAL:PROF:LIST?";
+      const char cmdSaveProfile[] PROGMEM = "CAL:PROF:SAVE";
+      const char cmdSetMode[] PROGMEM = "SYST:MODE";
+      const char cmdGetMode[] PROGMEM = "SYST:MODE?";
+      const char cmdMeasureRipple[] PROGMEM = "MEAS:RIPP?";
+      const char cmdSetTrigger[] PROGMEM = "CONF:TRIG";
+      const char cmdGetTrigger[] PROGMEM = "CONF:TRIG?";
+      const char cmdArmCapture[] PROGMEM = "CAPT:ARM";
+      const char cmdGetCaptureState[] PROGMEM = "CAPT:STAT?";
+      const char cmdGetCaptureData[] PROGMEM = "CAPT:DATA?";
+      const char cmdSetStep[] PROGMEM = "CONF:STEP";
+      const char cmdGetStep[] PROGMEM = "CONF:STEP?";
+      const char cmdGetStepData[] PROGMEM = "STEP:DATA?";
+      const char cmdSetHistogram[] PROGMEM = "CONF:HIST";
+      const char cmdGetHistogram[] PROGMEM = "CONF:HIST?";
+      const char cmdGetHistogramData[] PROGMEM = "HIST:DATA?";
+      const char cmdResetHistogram[] PROGMEM = "HIST:RES";
+      const char cmdGetEvents[] PROGMEM = "LOG:DATA?";
+      const char cmdGetEventCount[] PROGMEM = "LOG:COUN?";
+      const char cmdClearEvents[] PROGMEM = "LOG:CLR";
+      const char cmdGetJitter[] PROGMEM = "DIAG:JITT?";
+      const char cmdGetLateness[] PROGMEM = "DIAG:LATE?";
+      const char cmdResetTiming[] PROGMEM = "DIAG:RES";
+      const char cmdRunBenchmarks[] PROGMEM = "DIAG:BENCH?";
+      const char cmdGetLoopCycles[] PROGMEM = "DIAG:LOOP?";
+      const char cmdGetBootTimes[] PROGMEM = "DIAG:BOOT?";
+      const char cmdGetResetCause[] PROGMEM = "DIAG:RST?";
+      const char cmdGetResetCounts[] PROGMEM = "DIAG:RST:COUN?";
+      const char cmdGetOverruns[] PROGMEM = "DIAG:OVER?";
+
+      // Command table
+      const command commands[] PROGMEM = {
+          {cmdIdentify, identify},
+          {cmdMeasureVoltage, measureVoltage},
+          {cmdMeasureCurrent, measureCurrent},
+          {cmdMeasureVoltagePos, measureVoltagePos},
+          {cmdMeasureVoltageNeg, measureVoltageNeg},
+          {cmdMeasureCurrentPos, measureCurrentPos},
+          {cmdMeasureCurrentNeg, measureCurrentNeg},
+          {cmdMeasureAll, measureAll},
+          {cmdSetAveraging, setAveraging},
+          {cmdGetAveraging, getAveraging},
+          {cmdSetRule, setRule},
+          {cmdGetRule, getRule},
+          {cmdSaveRules, saveRules},
+          {cmdMeasureTracking, measureTracking},
+          {cmdSetTracking, setTracking},
+          {cmdGetTracking, getTracking},
+          {cmdSetMute, setMute},
+          {cmdGetMute, getMute},
+          {cmdGetTrip, getTrip},
+          {cmdResetTrip, resetTrip},
+          {cmdGetCalibrated, getCalibrated},
+          {cmdSetCalibrationSamples, setCalibrationSamples},
+          {cmdGetCalibrationSamples, getCalibrationSamples},
+          {cmdSetProfile, setProfile},
+          {cmdGetProfile, getProfile},
+          {cmdListProfiles, listProfiles},
+          {cmdSaveProfile, saveProfile},
+          {cmdSetMode, setMode},
+          {cmdGetMode, getMode},
+          {cmdMeasureRipple, measureRipple},
+          {cmdSetTrigger, setTrigger},
+          {cmdGetTrigger, getTrigger},
+          {cmdArmCapture, armCapture},
+          {cmdGetCaptureState, getCaptureState},
+          {cmdGetCaptureData, getCaptureData},
+          {cmdSetStep, setStep},
+          {cmdGetStep, getStep},
+          {cmdGetStepData, getStepData},
+          {cmdSetHistogram, setHistogram},
+          {cmdGetHistogram, getHistogram},
+          {cmdGetHistogramData, getHistogramData},
+          {cmdResetHistogram, resetHistogram},
+          {cmdGetEvents, getEvents},
+          {cmdGetEventCount, getEventCount},
+          {cmdClearEvents, clearEvents},
+          {cmdGetJitter, getJitter},
+          {cmdGetLateness, getLateness},
+          {cmdResetTiming, resetTiming},
+          {cmdRunBenchmarks, runBenchmarks},
+          {cmdGetLoopCycles, getLoopCycles},
+          {cmdGetBootTimes, getBootTimes},
+          {cmdGetResetCause, getResetCause},
+          {cmdGetResetCounts, getResetCounts},
+          {cmdGetOverruns, getOverruns},
+      };
+
+      // Averaging counts, indexed by INA260_AveragingCount
+      const uint16_t averagingCounts[] PROGMEM = {1, 4, 16, 64, 128, 256, 512, 1024};
+
+    }
+
+    /**
+    * @brief Opens the serial port.
+    *
+    * @param baud   Serial port speed
+    */
+    void setup(const uint32_t baud) {
+        Serial.begin(baud);
+    }
+
+    /**
+    * @brief Called each time through the scheduling loop to collect and execute commands.
+    *
+    * Continues any multi-line reply, then takes at most CHARS_PER_UPDATE characters from
+    * the serial receive buffer. A complete command is executed once the transmit buffer
+    * has room for its reply; until then, further characters are left in the receive buffer.
+    * A line too long for the buffer is answered with "ERR" and not executed.
+    */
+    void update(void) {
+        if (Serial.availableForWrite() < REPLY_MAX) {
+            return;
+        }
+        if (pending != nullptr) {
+            if (!pending(pendingLine++)) {
+                pending = nullptr;
+            }
+            return;
+        }
+        if (lineReady) {
+            lineReady = false;
+            if (lineOverflow) {
+                lineOverflow = false;
+                error();
+            }
+            else {
+                execute(line);
+            }
+            return;
+        }
+
+        for (auto n = uint8_t{0}; n < CHARS_PER_UPDATE && Serial.available() > 0; n++) {
+            const char c = static_cast<char>(Serial.read());
+            if (c == '\n' || c == '\r') {
+                if (lineLength > 0) {
+                    line[lineLength] = 0;
+                    lineLength = 0;
+                    lineReady = true;
+                }
+                return;
+            }
+            if (lineLength < sizeof(line) - 1) {
+                line[lineLength++] = c;
+            }
+            else {
+                lineOverflow = true;
+            }
+        }
+    }
+
+    /**
+    * @brief Starts a reply longer than one line.
+    *
+    * The continuation is called with the line number (starting at zero) each time the task
+    * runs and the transmit buffer has room for a line, until it returns false. Lines, with
+    * their line ending, must be no longer than REPLY_MAX characters.
+    *
+    * @param next   Function sending the requested line of the reply
+    */
+    void startReply(continuation next) {
+        pendingLine = 0;
+        pending = next;
+    }
+
+    // Functions used only in this task
+    namespace
+    {
+
+      /**
+      * @brief Looks up a command line in the command table and calls its handler.
+      *
+      * @param text   Null terminated command line; modified in place
+      */
+      void execute(char *text) {
+          char *args = strchr(text, ' ');
+          if (args != nullptr) {
+              *args++ = 0;
+          }
+          else {
+              args = text + strlen(text);
+          }
+
+          for (auto n = uint8_t{0}; n < sizeof(commands) / sizeof(commands[0]); n++) {
+              if (strcasecmp_P(text, reinterpret_cast<const char*>(pgm_read_ptr(&commands[n].name))) == 0) {
+                  reinterpret_cast<void (*)(char*)>(pgm_read_ptr(&commands[n].handler))(args);
+                  return;
+              }
+          }
+          error();
+      }
+
+      /**
+      * @brief Parses a comma separated list of integers.
+      *
+      * @param text          Text to parse
+      * @param[out] values   Returns the integers
+      * @param count         Number of integers expected
+      *
+      * @return False unless exactly @p count integers were found, each in the range of int16_t
+      */
+      bool parseIntegers(char *text, int16_t values[], const uint8_t count) {
+          for (auto n = uint8_t{0}; n < count; n++) {
+              char *end;
+              const long value = strtol(text, &end, 10);
+              if (end == text || *end != ((n == count - 1) ? 0 : ',') || value < INT16_MIN || value > INT16_MAX) {
+                  return false;
+              }
+              values[n] = static_cast<int16_t>(value);
+              text = end + 1;
+          }
+          return true;
+      }
+
+      void reply(const int16_t value) {
+          Serial.println(value);
+      }
+
+      void ok(void) {
+          Serial.println(F("OK"));
+      }
+
+      void error(void) {
+          Serial.println(F("ERR"));
+      }
+
+      /**
+      * @brief Continuation replying OK once queued EEPROM writes are complete; sends nothing until then.
+      *
+      * @param line   Unused
+      */
+      bool finishWrite(const uint8_t line) {
+          if (EepromWriter::busy()) {
+              return true;
+          }
+          ok();
+          return false;
+      }
+
+      void identify(char *args) {
+          Serial.println(F("PSMonitor,dual supply monitor"));
+      }
+
+      /**
+      * @brief Replies with the latest reading of one output.
+      *
+      * @param args    Output number
+      * @param group   MONITOR_SELECT_GROUP
+      */
+      void measureOutput(char *args, const int16_t group) {
+          int16_t output;
+          if (parseIntegers(args, &output, 1) && output >= 0 && output < MONITOR_OUTPUTS) {
+              reply(Readings::get(group + output));
+          }
+          else {
+              error();
+          }
+      }
+
+      /**
+      * @brief Replies with the latest reading of a fixed output, if the monitor has it.
+      *
+      * @param group    MONITOR_SELECT_GROUP
+      * @param output   Output number
+      */
+      void measureFixedOutput(const int16_t group, const uint8_t output) {
+          if (output < MONITOR_OUTPUTS) {
+              reply(Readings::get(group + output));
+          }
+          else {
+              error();
+          }
+      }
+
+      void measureVoltage(char *args) {
+          measureOutput(args, MONITOR_VOLTAGE);
+      }
+
+      void measureCurrent(char *args) {
+          measureOutput(args, MONITOR_CURRENT);
+      }
+
+      void measureVoltagePos(char *args) {
+          measureFixedOutput(MONITOR_VOLTAGE, 0);
+      }
+
+      void measureVoltageNeg(char *args) {
+          measureFixedOutput(MONITOR_VOLTAGE, 1);
+      }
+
+      void measureCurrentPos(char *args) {
+          measureFixedOutput(MONITOR_CURRENT, 0);
+      }
+
+      void measureCurrentNeg(char *args) {
+          measureFixedOutput(MONITOR_CURRENT, 1);
+      }
+
+      void measureAll(char *args) {
+          int16_t values[MONITOR_VALUES];
+          (void) Readings::read(values);
+          for (auto channel = uint8_t{0}; channel < MONITOR_VALUES; channel++) {
+              if (channel != 0) {
+                  Serial.print(',');
+              }
+              Serial.print(values[channel]);
+          }
+          Serial.println();
+      }
+
+      void setAveraging(char *args) {
+          int16_t count;
+          if (parseIntegers(args, &count, 1)) {
+              for (auto n = uint8_t{INA260_COUNT_1}; n <= INA260_COUNT_1024; n++) {
+                  if (pgm_read_word(&averagingCounts[n]) == static_cast<uint16_t>(count)) {
+                      MonitorTask::setAveragingCount(static_cast<INA260_AveragingCount>(n));
+                      ok();
+                      return;
+                  }
+              }
+          }
+          error();
+      }
+
+      void getAveraging(char *args) {
+          Serial.println(pgm_read_word(&averagingCounts[MonitorTask::getAveragingCount() & 0x07]));
+      }
+
+      /**
+      * @brief Sends one alert rule.
+      *
+      * @param index   Rule number
+      */
+      void sendRule(const uint8_t index) {
+          alert_rule rule;
+          (void) Alerts::getRule(index, rule);
+          (void) sprintf(string_buf, "%u,%u,%u,", index, rule.channel, rule.type);
+          Serial.print(string_buf);
+          Serial.print(rule.threshold);
+          Serial.print(',');
+          Serial.print(rule.hysteresis);
+          Serial.print(',');
+          Serial.println(rule.duration);
+      }
+
+      /**
+      * @brief Continuation sending every alert rule, one per line.
+      *
+      * @param line   Rule number
+      */
+      bool sendAllRules(const uint8_t line) {
+          sendRule(line);
+          return line + 1 < ALERT_RULES;
+      }
+
+      void setRule(char *args) {
+          int16_t values[6];
+          alert_rule rule;
+          if (parseIntegers(args, values, 6)) {
+              rule.channel = values[1];
+              rule.type = values[2];
+              rule.threshold = values[3];
+              rule.hysteresis = values[4];
+              rule.duration = values[5];
+              if (values[0] >= 0 && values[5] >= 0 && Alerts::setRule(values[0], rule)) {
+                  ok();
+                  return;
+              }
+          }
+          error();
+      }
+
+      void getRule(char *args) {
+          int16_t index;
+          if (*args == 0) {
+              startReply(sendAllRules);
+          }
+          else if (parseIntegers(args, &index, 1) && index >= 0 && index < ALERT_RULES) {
+              sendRule(index);
+          }
+          else {
+              error();
+          }
+      }
+
+      void saveRules(char *args) {
+          Alerts::save();
+          startReply(finishWrite);
+      }
+
+      /**
+      * @brief Continuation sending the tracking of each output against output 0, one per line.
+      *
+      * @param line   Line number; output line + 1
+      */
+      bool sendTracking(const uint8_t line) {
+          const uint8_t output = line + 1;
+          Serial.print(Tracking::error(output));
+          Serial.print(',');
+          Serial.print(Tracking::trend(output));
+          Serial.print(',');
+          Serial.println(Tracking::alarm(output) ? 1 : 0);
+          return output + 1 < MONITOR_OUTPUTS;
+      }
+
+      void measureTracking(char *args) {
+          if (MONITOR_OUTPUTS > 1) {
+              startReply(sendTracking);
+          }
+          else {
+              error();
+          }
+      }
+
+      void setTracking(char *args) {
+          int16_t values[2];
+          if (parseIntegers(args, values, 2) && Tracking::setLimit(values[0], values[1])) {
+              startReply(finishWrite);
+          }
+          else {
+              error();
+          }
+      }
+
+      void getTracking(char *args) {
+          int16_t limit, hysteresis;
+          Tracking::getLimit(limit, hysteresis);
+          Serial.print(limit);
+          Serial.print(',');
+          Serial.println(hysteresis);
+      }
+
+      void setMute(char *args) {
+          if (strcasecmp_P(args, PSTR("ON")) == 0) {
+              if (!BuzzerTask::muted()) {
+                  BuzzerTask::mute();
+              }
+              ok();
+          }
+          else if (strcasecmp_P(args, PSTR("OFF")) == 0) {
+              if (BuzzerTask::muted()) {
+                  BuzzerTask::unmute();
+              }
+              ok();
+          }
+          else {
+              error();
+          }
+      }
+
+      void getMute(char *args) {
+          reply(BuzzerTask::muted());
+      }
+
+      void getTrip(char *args) {
+          reply(Protection::tripped());
+      }
+
+      void resetTrip(char *args) {
+          reply(Protection::reset() ? 0 : 1);
+      }
+
+      void getCalibrated(char *args) {
+          reply(Calibration::calibrated());
+      }
+
+      void setCalibrationSamples(char *args) {
+          int16_t count;
+          if (parseIntegers(args, &count, 1) && count >= 0 && count <= UINT8_MAX &&
+              CalibrateTask::setSampleCount(count)) {
+              ok();
+          }
+          else {
+              error();
+          }
+      }
+
+      void getCalibrationSamples(char *args) {
+          reply(CalibrateTask::getSampleCount());
+      }
+
+      void setProfile(char *args) {
+          int16_t index;
+          if (parseIntegers(args, &index, 1) && index >= 0 && index < CALIBRATION_PROFILES &&
+              Calibration::selectProfile(index)) {
+              startReply(finishWrite);
+          }
+          else {
+              error();
+          }
+      }
+
+      void getProfile(char *args) {
+          reply(Calibration::activeProfile());
+      }
+
+      /**
+      * @brief Continuation sending one calibration profile per line.
+      *
+      * @param line   Profile number
+      */
+      bool sendProfile(const uint8_t line) {
+          char name[CALIBRATION_NAME_LENGTH + 1];
+          (void) Calibration::profileName(line, name);
+          Serial.print(line);
+          Serial.print(',');
+          Serial.println(name);
+          return line + 1 < CALIBRATION_PROFILES;
+      }
+
+      void listProfiles(char *args) {
+          startReply(sendProfile);
+      }
+
+      void saveProfile(char *args) {
+          char *name;
+          const long index = strtol(args, &name, 10);
+          if (name != args && *name == ',' && name[1] != 0 && index >= 0 && index < CALIBRATION_PROFILES &&
+              Calibration::saveProfile(index, name + 1)) {
+              startReply(finishWrite);
+          }
+          else {
+              error();
+          }
+      }
+
+      // Mode names for SYST:MODE, indexed by STATE (measurement modes only)
+      const char modeNormal[] PROGMEM = "NORM";
+      const char modeCalibrate[] PROGMEM = "CAL";
+      const char modeTerminate[] PROGMEM = "FAULT";
+      const char modeRipple[] PROGMEM = "RIPP";
+      const char modeCapture[] PROGMEM = "CAPT";
+      const char modeStep[] PROGMEM = "STEP";
+      const char *const modeNames[] PROGMEM = {modeNormal, modeCalibrate, modeTerminate, modeRipple, modeCapture, modeStep};
+      static_assert(sizeof(modeNames) / sizeof(modeNames[0]) == MODE_COUNT, "Every mode must have a name");
+
+      void setMode(char *args) {
+          for (auto mode = uint8_t{0}; mode < sizeof(modeNames) / sizeof(modeNames[0]); mode++) {
+              if (strcasecmp_P(args, reinterpret_cast<const char*>(pgm_read_ptr(&modeNames[mode]))) == 0) {
+                  if (changeMode(mode)) {
+                      ok();
+                      return;
+                  }
+                  break;
+              }
+          }
+          error();
+      }
+
+      void getMode(char *args) {
+          Serial.println(reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&modeNames[currentMode])));
+      }
+
+      /**
+      * @brief Continuation sending ripple results: peak to peak, RMS, then the sample rate.
+      *
+      * @param line   Line number
+      */
+      bool sendRipple(const uint8_t line) {
+          if (line == 2) {
+              Serial.println(RippleTask::sampleRate());
+              return false;
+          }
+          for (auto channel = uint8_t{0}; channel < MONITOR_VALUES; channel++) {
+              if (channel != 0) {
+                  Serial.print(',');
+              }
+              Serial.print((line == 0) ? RippleTask::peakToPeak(channel) : RippleTask::rms(channel));
+          }
+          Serial.println();
+          return true;
+      }
+
+      void measureRipple(char *args) {
+          startReply(sendRipple);
+      }
+
+      void setTrigger(char *args) {
+          int16_t values[4];
+          if (parseIntegers(args, values, 4) && values[0] >= 0 && values[2] >= 0 && values[3] >= 0 &&
+              CaptureTask::setTrigger(values[0], values[1], values[2], values[3])) {
+              ok();
+              return;
+          }
+          error();
+      }
+
+      void getTrigger(char *args) {
+          uint8_t channel, slope, pretrigger;
+          int16_t level;
+          CaptureTask::getTrigger(channel, level, slope, pretrigger);
+          (void) sprintf(string_buf, "%u,%d,%u,%u", channel, level, slope, pretrigger);
+          Serial.println(string_buf);
+      }
+
+      void armCapture(char *args) {
+          CaptureTask::arm();
+          ok();
+      }
+
+      void getCaptureState(char *args) {
+          Serial.print(CaptureTask::state());
+          Serial.print(',');
+          Serial.println(CaptureTask::samplePeriod());
+      }
+
+      /**
+      * @brief Continuation sending one captured sample set per line, oldest first.
+      *
+      * @param line   Line number (sample set)
+      */
+      bool sendCapture(const uint8_t line) {
+          int16_t frame[MONITOR_VALUES];
+          uint8_t channel, slope, pretrigger;
+          int16_t level;
+          if (!CaptureTask::getFrame(line, frame)) {
+              return false;
+          }
+          CaptureTask::getTrigger(channel, level, slope, pretrigger);
+          Serial.print(static_cast<int16_t>(line) - pretrigger);
+          for (auto value : frame) {
+              Serial.print(',');
+              Serial.print(value);
+          }
+          Serial.println();
+          return line + 1 < CAPTURE_FRAMES;
+      }
+
+      void getCaptureData(char *args) {
+          if (CaptureTask::state() == CAPTURE_DONE) {
+              startReply(sendCapture);
+          }
+          else {
+              error();
+          }
+      }
+
+      void setStep(char *args) {
+          int16_t values[2];
+          if (parseIntegers(args, values, 2) && StepTask::setDetection(values[0], values[1])) {
+              ok();
+              return;
+          }
+          error();
+      }
+
+      void getStep(char *args) {
+          int16_t threshold, band;
+          StepTask::getDetection(threshold, band);
+          (void) sprintf(string_buf, "%d,%d", threshold, band);
+          Serial.println(string_buf);
+      }
+
+      /**
+      * @brief Continuation sending the last load step on each output, one per line.
+      *
+      * @param line   Line number (output)
+      */
+      bool sendStep(const uint8_t line) {
+          step_result step = {0, 0, 0, 0, false};
+          (void) StepTask::result(line, step);
+          Serial.print(StepTask::events(line));
+          Serial.print(',');
+          Serial.print(step.step);
+          Serial.print(',');
+          Serial.print(step.droop);
+          Serial.print(',');
+          Serial.print(step.overshoot);
+          Serial.print(',');
+          if (step.settled) {
+              Serial.println(step.settling);
+          }
+          else {
+              Serial.println(-1);
+          }
+          return line + 1 < MONITOR_OUTPUTS;
+      }
+
+      void getStepData(char *args) {
+          startReply(sendStep);
+      }
+
+      void setHistogram(char *args) {
+          int16_t shift;
+          if (strcasecmp_P(args, PSTR("LOG")) == 0) {
+              (void) Histogram::configure(HISTOGRAM_LOG, 0);
+              ok();
+          }
+          else if (strncasecmp_P(args, PSTR("LIN,"), 4) == 0 && parseIntegers(args + 4, &shift, 1) &&
+                   shift >= 0 && Histogram::configure(HISTOGRAM_LINEAR, shift)) {
+              ok();
+          }
+          else {
+              error();
+          }
+      }
+
+      void getHistogram(char *args) {
+          if (Histogram::scale() == HISTOGRAM_LOG) {
+              Serial.println(F("LOG"));
+          }
+          else {
+              Serial.print(F("LIN,"));
+              Serial.println(Histogram::shift());
+          }
+      }
+
+      /**
+      * @brief Continuation sending one histogram bin per line.
+      *
+      * @param line   Bin number
+      */
+      bool sendHistogram(const uint8_t line) {
+          Serial.print(Histogram::lowerBound(line));
+          for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+              Serial.print(',');
+              Serial.print(Histogram::count(output, line));
+          }
+          Serial.println();
+          return line + 1 < HISTOGRAM_BINS;
+      }
+
+      void getHistogramData(char *args) {
+          startReply(sendHistogram);
+      }
+
+      void resetHistogram(char *args) {
+          Histogram::reset();
+          ok();
+      }
+
+      /**
+      * @brief Continuation sending one logged event per line, newest first.
+      *
+      * @param line   Event (0 for the newest)
+      */
+      bool sendEvent(const uint8_t line) {
+          event_entry event;
+          if (!EventLog::entry(line, event)) {
+              Serial.println();
+              return false;
+          }
+          Serial.print(event.sequence);
+          Serial.print(',');
+          Serial.print(event.uptime);
+          Serial.print(',');
+          Serial.print(event.rule);
+          Serial.print(',');
+          Serial.print(event.channel);
+          Serial.print(',');
+          Serial.print(event.peak);
+          Serial.print(',');
+          Serial.println(static_cast<uint32_t>(event.duration) << EVENT_DURATION_SHIFT);
+          return line + 1 < EventLog::count();
+      }
+
+      void getEvents(char *args) {
+          startReply(sendEvent);
+      }
+
+      void getEventCount(char *args) {
+          Serial.print(EventLog::count());
+          Serial.print(',');
+          Serial.println(EventLog::dropped());
+      }
+
+      void clearEvents(char *args) {
+          EventLog::clear();
+          ok();
+      }
+
+      /**
+      * @brief Continuation sending one sample lateness bin per line.
+      *
+      * @param line   Bin number
+      */
+      bool sendJitter(const uint8_t line) {
+          Serial.print((line == 0) ? 0 : JITTER_UNIT << (line - 1));
+          Serial.print(',');
+          Serial.println(MonitorTask::getJitter(line));
+          return line + 1 < JITTER_BINS;
+      }
+
+      void getJitter(char *args) {
+          startReply(sendJitter);
+      }
+
+      void getLateness(char *args) {
+          Serial.print(MonitorTask::getMissedDeadlines());
+          Serial.print(',');
+          Serial.println(MonitorTask::getMaxLateness());
+      }
+
+      void resetTiming(char *args) {
+          MonitorTask::resetTiming();
+          Benchmark::resetLoop();
+          ok();
+      }
+
+      /**
+      * @brief Continuation running one benchmark per line.
+      *
+      * @param line   Benchmark number
+      */
+      bool sendBenchmark(const uint8_t line) {
+          Serial.print(Benchmark::name(line));
+          Serial.print(',');
+          Serial.println(Benchmark::run(line));
+          return line + 1 < Benchmark::count();
+      }
+
+      void runBenchmarks(char *args) {
+          startReply(sendBenchmark);
+      }
+
+      /**
+      * @brief Continuation sending the loop statistics, one mode per line.
+      *
+      * @param line   Mode (STATE)
+      */
+      bool sendLoopCycles(const uint8_t line) {
+          Serial.print(reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&modeNames[line])));
+          Serial.print(',');
+          Serial.print(Benchmark::loopMean(line));
+          Serial.print(',');
+          Serial.println(Benchmark::loopMax(line));
+          return line + 1 < MODE_COUNT;
+      }
+
+      void getLoopCycles(char *args) {
+          startReply(sendLoopCycles);
+      }
+
+      /**
+      * @brief Continuation sending the time each startup phase ended, one per line.
+      *
+      * @param line   Phase (BOOT_PHASE)
+      */
+      bool sendBootTime(const uint8_t line) {
+          Serial.print(Benchmark::bootPhaseName(line));
+          Serial.print(',');
+          Serial.println(Benchmark::bootTime(line));
+          return line + 1 < BOOT_PHASES;
+      }
+
+      void getBootTimes(char *args) {
+          startReply(sendBootTime);
+      }
+
+      void getResetCause(char *args) {
+          Serial.print(Watchdog::causeName(Watchdog::lastCause()));
+          Serial.print(',');
+          Serial.println(Watchdog::taskName(Watchdog::stalledTask()));
+      }
+
+      /**
+      * @brief Continuation sending the reset count for each cause, one per line.
+      *
+      * @param line   Cause (RESET_CAUSE)
+      */
+      bool sendResetCount(const uint8_t line) {
+          Serial.print(Watchdog::causeName(line));
+          Serial.print(',');
+          Serial.println(Watchdog::resets(line));
+          return line + 1 < RESET_CAUSES;
+      }
+
+      void getResetCounts(char *args) {
+          startReply(sendResetCount);
+      }
+
+      /**
+      * @brief Continuation sending the overrun count for each task, one per line.
+      *
+      * @param line   Task (WATCHDOG_TASK)
+      */
+      bool sendOverruns(const uint8_t line) {
+          Serial.print(Watchdog::taskName(line));
+          Serial.print(',');
+          Serial.println(Watchdog::overruns(line));
+          return line + 1 < TASK_COUNT;
+      }
+
+      void getOverruns(char *args) {
+          startReply(sendOverruns);
+      }
+
+    }
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+/**
+ * @file SerialTask.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for SerialTask.
+ *
+ */
+
+#ifndef _SERIALTASK_H
+#define _SERIALTASK_H
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+namespace SerialTask {
+
+    // Functions
+    void setup(const uint32_t baud);
+    void update(void);
+    void startReply(bool (*next)(const uint8_t line));
+};
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * @file StepAnalysis.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Measures the response of one supply output to a load step.
+ *
+ * Watches an output's current for a step: a sample set whose current differs from the running
+ * mean of the current by at least the detection threshold. The running means of current and
+ * voltage are only updated while no step is being analysed, so the voltage before the step is
+ * known without keeping past samples.
+ *
+ * For STEP_WINDOW sample sets after a step, the voltage magnitude is compared with its value
+ * before the step: the furthest it falls below (droop) and rises above (overshoot) are kept,
+ * and the time of the last sample set outside the settling band. The settling time is the time
+ * from the step to that sample set; the output has not settled if it was outside the band in
+ * the last STEP_HOLD sample sets of the window (e.g. because its load regulation is worse than
+ * the band).
+ *
+ * Uses no Arduino functions, so it can be tested on the host with synthetic traces.
+ *
+ * To use the step analysis, for each output:
+ *      - StepAnalysis::reset() - start waiting for a step from the present level
+ *      - StepAnalysis::analyze() - analyse each sample set; returns true with the result of a step
+ */
+
+// Include our own header file
+#include "StepAnalysis.h"
+
+namespace StepAnalysis {
+
+    // Running means of current and voltage weight each sample set 2^-STEP_MEAN_SHIFT
+    constexpr uint8_t STEP_MEAN_SHIFT = 4;
+
+    /**
+    * @brief Starts waiting for a step, with the running means at the present level.
+    *
+    * @param a         Analysis of the output
+    * @param current   Current in mA
+    * @param voltage   Voltage magnitude in mV
+    */
+    void reset(step_analyzer &a, const int16_t current, const int16_t voltage) {
+        a.meanCurrent = static_cast<int32_t>(current) << STEP_MEAN_SHIFT;
+        a.meanVoltage = static_cast<int32_t>(voltage) << STEP_MEAN_SHIFT;
+        a.samples = 0;
+    }
+
+    /**
+    * @brief Analyses one sample set: detects a step, or measures the response to one.
+    *
+    * When the analysis of a step completes, its result is left in a.current and the
+    * analyzer starts waiting for the next step from the present level.
+    *
+    * @param a           Analysis of the output
+    * @param current     Current in mA
+    * @param voltage     Voltage magnitude in mV
+    * @param now         Time of the sample set in microseconds
+    * @param threshold   Least change in current that is a step, in mA
+    * @param band        Distance from the voltage before the step counted as settled, in mV
+    *
+    * @return True if the analysis of a step completed with this sample set
+    */
+    bool analyze(step_analyzer &a, const int16_t current, const int16_t voltage, const uint32_t now,
+                 const int16_t threshold, const int16_t band) {
+        if (a.samples == 0) {
+            const int16_t change = current - static_cast<int16_t>(a.meanCurrent >> STEP_MEAN_SHIFT);
+            if (change < threshold && change > -threshold) {
+                a.meanCurrent += current - (a.meanCurrent >> STEP_MEAN_SHIFT);
+                a.meanVoltage += voltage - (a.meanVoltage >> STEP_MEAN_SHIFT);
+                return false;
+            }
+            a.reference = static_cast<int16_t>(a.meanVoltage >> STEP_MEAN_SHIFT);
+            a.start = now;
+            a.lastOutside = 0;
+            a.current = {change, 0, 0, 0, true};
+        }
+
+        a.samples++;
+        const int16_t deviation = voltage - a.reference;
+        if (-deviation > a.current.droop) {
+            a.current.droop = -deviation;
+        }
+        if (deviation > a.current.overshoot) {
+            a.current.overshoot = deviation;
+        }
+        if (deviation > band || deviation < -band) {
+            a.lastOutside = a.samples;
+            a.current.settling = now - a.start;
+        }
+        if (a.samples < STEP_WINDOW) {
+            return false;
+        }
+
+        a.current.settled = a.lastOutside <= STEP_WINDOW - STEP_HOLD;
+        reset(a, current, voltage);
+        return true;
+    }
+
+}
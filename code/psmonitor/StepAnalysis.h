@@ -0,0 +1,50 @@
+#pragma once
+/**
+ * @file StepAnalysis.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for the load step analysis used by StepTask.
+ *
+ */
+
+#ifndef _STEPANALYSIS_H
+#define _STEPANALYSIS_H
+
+// No Arduino dependencies, so the analysis can be tested on the host
+#include <stdint.h>
+
+// Sample sets analysed after each load step; the voltage must stay settled for the last STEP_HOLD
+constexpr uint8_t STEP_WINDOW = 200;
+constexpr uint8_t STEP_HOLD = 32;
+
+/// Response of one output to a load step
+struct step_result {
+    int16_t step;           // Change in current, in mA
+    int16_t droop;          // Furthest the voltage magnitude fell below its value before the step, in mV
+    int16_t overshoot;      // Furthest the voltage magnitude rose above its value before the step, in mV
+    uint32_t settling;      // Time from the step until the voltage was last outside the band, in us
+    bool settled;           // False if the voltage had not settled by the end of the window
+};
+
+/// Analysis of one output
+struct step_analyzer {
+    int32_t meanCurrent;        // Running means, scaled by 2^STEP_MEAN_SHIFT; not updated during a step
+    int32_t meanVoltage;        // (voltage magnitude)
+    int16_t reference;          // Voltage magnitude before the step
+    uint8_t samples;            // Sample sets analysed since the step; 0 while waiting for one
+    uint8_t lastOutside;        // Sample set last outside the band; 0 if none
+    uint32_t start;             // Time of the step
+    step_result current;        // Step being analysed; the result once analyze() returns true
+};
+
+namespace StepAnalysis {
+
+    void reset(step_analyzer &a, const int16_t current, const int16_t voltage);
+    bool analyze(step_analyzer &a, const int16_t current, const int16_t voltage, const uint32_t now,
+                 const int16_t threshold, const int16_t band);
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+/**
+ * @file StepTask.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Implements a StepTask that measures how each supply output recovers from load steps.
+ *
+ * Implements a StepTask that switches the INA260 sensors to fast sampling (as the Ripple task
+ * does) and feeds each output's current and voltage magnitude to its own step analysis
+ * (StepAnalysis.cpp), which detects a load step and measures the droop, overshoot and settling
+ * time that follow it. Each output is analysed independently, so steps on several outputs
+ * at once are all measured.
+ *
+ * The results of the last step on the output shown are displayed (double click switches output).
+ *
+ * To use the Step task:
+ *      - StepTask::setup() - setup the task
+ *      - StepTask::start() - reconfigure the sensors for fast sampling; call when entering step mode
+ *      - StepTask::stop() - restore the sensor configuration; call when leaving step mode
+ *      - StepTask::update() - run the step analysis; call once each time through scheduler
+ *      - StepTask::nextPage() - switch the display to the next output
+ *      - StepTask::setDetection() / StepTask::getDetection() - step threshold and settling band
+ *      - StepTask::events(), StepTask::result() - results
+ *
+ * Intended to be run by a simple, non-preemptive round robin scheduler, where each task
+ * is responsible for relinquishing control; this code is *not threadsafe* and must not be
+ * interrupted.
+ */
+
+// Include standard headers as needed
+#include <Arduino.h>
+
+// Include our own header file
+#include "StepTask.h"
+
+// Include the Monitor task that owns the sensors
+#include "MonitorTask.h"
+
+// External storage shared between tasks
+#include "globals.h"
+
+namespace StepTask {
+
+    // Sample sets read each time the task runs (bounds run time)
+    constexpr uint8_t STEP_BURST = 8;
+
+    // Default step threshold (mA) and settling band (mV)
+    constexpr int16_t STEP_DEFAULT_THRESHOLD = 100;
+    constexpr int16_t STEP_DEFAULT_BAND = 25;
+
+    LiquidCrystal *lcd = nullptr;
+    auto shownOutput = uint8_t{0};
+
+    auto threshold = int16_t{STEP_DEFAULT_THRESHOLD};
+    auto band = int16_t{STEP_DEFAULT_BAND};
+
+    // Analysis of each output
+    step_analyzer analyzers[MONITOR_OUTPUTS];
+    auto primed = bool{false};
+
+    // Results of the last step on each output
+    step_result results[MONITOR_OUTPUTS];
+    uint16_t eventCounts[MONITOR_OUTPUTS] = {};
+
+    // Forward declarations of functions used only in this task
+    namespace
+    {
+
+      void record(const uint8_t output, const step_result &step);
+      void display(void);
+
+    }
+
+    /**
+    * @brief Configures the step task LCD display.
+    *
+    * @param display   Pointer to the LCD display object
+    */
+    void setup(LiquidCrystal *display) {
+        lcd = display;
+    }
+
+    /**
+    * @brief Reconfigures the sensors and I2C bus for fast sampling and waits for a step.
+    *
+    */
+    void start(void) {
+        MonitorTask::setFastSampling(true);
+        primed = false;
+        display();
+    }
+
+    /**
+    * @brief Restores the sensor and I2C bus configuration in use before start().
+    *
+    */
+    void stop(void) {
+        MonitorTask::setFastSampling(false);
+    }
+
+    /**
+    * @brief Called each time through the scheduling loop to analyse load steps.
+    *
+    * Reads STEP_BURST sample sets and analyses each output; when the analysis of a step
+    * completes, its results are displayed.
+    */
+    void update(void) {
+        int16_t frame[MONITOR_VALUES];
+        for (auto n = uint8_t{0}; n < STEP_BURST; n++) {
+            MonitorTask::readFrame(frame);
+            const uint32_t now = micros();
+            for (auto output = uint8_t{0}; output < MONITOR_OUTPUTS; output++) {
+                const int16_t current = frame[MONITOR_CURRENT + output];
+                const int16_t voltage = (frame[MONITOR_VOLTAGE + output] < 0) ? -frame[MONITOR_VOLTAGE + output] : frame[MONITOR_VOLTAGE + output];
+                step_analyzer &a = analyzers[output];
+                if (!primed) {
+                    StepAnalysis::reset(a, current, voltage);
+                }
+                else if (StepAnalysis::analyze(a, current, voltage, now, threshold, band)) {
+                    record(output, a.current);
+                }
+            }
+            primed = true;
+        }
+    }
+
+    /**
+    * @brief Switches the display to the next output.
+    *
+    */
+    void nextPage(void) {
+        shownOutput = (shownOutput + 1) % MONITOR_OUTPUTS;
+        display();
+    }
+
+    /**
+    * @brief Sets the current change that counts as a step, and the settling band.
+    *
+    * @param step_threshold   Least change in current, in mA
+    * @param settling_band    Distance from the voltage before the step counted as settled, in mV
+    *
+    * @return False if either is not positive
+    */
+    bool setDetection(const int16_t step_threshold, const int16_t settling_band) {
+        if (step_threshold <= 0 || settling_band <= 0) {
+            return false;
+        }
+        threshold = step_threshold;
+        band = settling_band;
+        return true;
+    }
+
+    void getDetection(int16_t &step_threshold, int16_t &settling_band) {
+        step_threshold = threshold;
+        settling_band = band;
+    }
+
+    /**
+    * @brief Gets the number of steps analysed on an output since startup; saturates.
+    *
+    * @param output   Output number
+    */
+    uint16_t events(const uint8_t output) {
+        return (output < MONITOR_OUTPUTS) ? eventCounts[output] : 0;
+    }
+
+    /**
+    * @brief Retrieves the results of the last step on an output.
+    *
+    * @param output       Output number
+    * @param[out] step    Returns the results
+    *
+    * @return False if no step has been analysed on the output
+    */
+    bool result(const uint8_t output, step_result &step) {
+        if (output >= MONITOR_OUTPUTS || eventCounts[output] == 0) {
+            return false;
+        }
+        step = results[output];
+        return true;
+    }
+
+    // Functions used only in this task
+    namespace
+    {
+
+      /**
+      * @brief Keeps the results of a step, and displays them.
+      *
+      * @param output   Output number
+      * @param step   Results of the step
+      */
+      void record(const uint8_t output, const step_result &step) {
+          results[output] = step;
+          if (eventCounts[output] != UINT16_MAX) {
+              eventCounts[output]++;
+          }
+          shownOutput = output;
+          display();
+      }
+
+      /**
+      * @brief Displays the results of the last step on the output shown.
+      *
+      * e.g. "V+ step   +250mA" over "D  35 O  12  4.7": droop and overshoot in mV, settling
+      * time in ms ("---" if not settled).
+      */
+      void display(void) {
+          const step_result &step = results[shownOutput];
+          lcd->setCursor(0, 0);
+          lcd->print('V');
+          lcd->print(MonitorTask::label(shownOutput));
+          if (eventCounts[shownOutput] == 0) {
+              lcd->print(F(" no step yet   "));
+              lcd->setCursor(0, 1);
+              lcd->print(F("                "));
+              return;
+          }
+          (void) sprintf(string_buf, " step%+7dmA", step.step);
+          lcd->print(string_buf);
+
+          lcd->setCursor(0, 1);
+          (void) sprintf(string_buf, "D%4d O%4d", (step.droop < 9999) ? step.droop : 9999,
+                         (step.overshoot < 9999) ? step.overshoot : 9999);
+          lcd->print(string_buf);
+          if (step.settled) {
+              const uint16_t tenths = step.settling / 100;
+              (void) sprintf(string_buf, "%3u.%u", tenths / 10, tenths % 10);
+              lcd->print(string_buf);
+          }
+          else {
+              lcd->print(F("  ---"));
+          }
+      }
+
+    }
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+/**
+ * @file StepTask.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for StepTask.
+ *
+ */
+
+#ifndef _STEPTASK_H
+#define _STEPTASK_H
+
+// Include headers for third party libraries
+#include <LiquidCrystal.h>
+
+// Load step analysis and step_result
+#include "StepAnalysis.h"
+
+namespace StepTask {
+
+    void setup(LiquidCrystal *display);
+    void start(void);
+    void stop(void);
+    void update(void);
+    void nextPage(void);
+
+    bool setDetection(const int16_t threshold, const int16_t band);
+    void getDetection(int16_t &threshold, int16_t &band);
+
+    // Results of the last step on each output, indexed by output
+    uint16_t events(const uint8_t output);
+    bool result(const uint8_t output, step_result &step);
+
+}
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * @file Tracking.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Monitors how closely each output tracks output 0 (e.g. the rails of a symmetric supply).
+ *
+ * The tracking error of output n is |V0| - |Vn|: zero for outputs whose magnitudes are equal,
+ * positive if output 0 is the larger; for a supply with a positive output 0 and a negative
+ * output 1 it is how closely the negative rail tracks the positive rail. It is computed from every set of readings the Monitor task takes
+ * and filtered with a running mean (a shift and two additions, so it costs next to nothing at the
+ * full acquisition rate). An output's tracking alarm is raised while its filtered error is further
+ * from zero than the limit, and clears once it is back inside the limit by the hysteresis. The
+ * limit is shared by all outputs; a limit of zero turns the alarms off.
+ *
+ * The trend is the change in the filtered error over the last minute (or since startup, for the
+ * first minute), sampled every TRACKING_TREND_STEP ms, so a slow drift of the rails apart shows
+ * before it reaches the limit.
+ *
+ * The limit and hysteresis are stored in EEPROM (with a CRC) when changed; if none are stored,
+ * the defaults from limits.h are used.
+ *
+ * To use the tracking monitor:
+ *      - Tracking::setup() - load the alarm limit from EEPROM
+ *      - Tracking::record() - add a set of readings; returns true while any alarm is raised
+ *      - Tracking::update() - sample the trends; call at least once every TRACKING_TREND_STEP ms
+ *      - Tracking::error(), Tracking::trend(), Tracking::alarm() - results for an output 1 - MONITOR_OUTPUTS - 1
+ *      - Tracking::setLimit() / Tracking::getLimit() - alarm limit and hysteresis
+ */
+
+// Standard header files
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <stddef.h>
+
+// Include our own header file
+#include "Tracking.h"
+
+// MonitorTask header to include MONITOR_* enums
+#include "MonitorTask.h"
+
+// Default tracking limits
+#include "limits.h"
+
+// EEPROM layout, CRC used to validate EEPROM data, and deferred writing
+#include "eeprom_map.h"
+#include "Crc16.h"
+#include "EepromWriter.h"
+
+namespace Tracking {
+
+    // Alarm limits as stored in EEPROM
+    struct tracking_limits {
+        int16_t limit;          // Greatest tracking error in millivolts; 0 for no alarm
+        int16_t hysteresis;     // Distance back inside the limit at which the alarm clears
+        uint16_t crc;
+    };
+    constexpr uint16_t crc_length = offsetof(tracking_limits, crc);
+    static_assert(sizeof(tracking_limits) <= EEPROM_TRACKING_END - EEPROM_TRACKING, "Tracking limits must fit in their EEPROM space");
+
+    tracking_limits limits;
+
+    // Per tracked output, indexed by output - 1
+    // Filtered tracking error, scaled by 2^TRACKING_FILTER_SHIFT
+    int32_t filtered[TRACKING_OUTPUTS] = {};
+    auto started = bool{false};
+    auto alarmMask = uint8_t{0};        // One bit per tracked output
+    static_assert(TRACKING_OUTPUTS <= 8, "Tracking alarms are kept as a bit mask");
+
+    // Filtered error at each trend step, oldest overwritten first
+    int16_t history[TRACKING_OUTPUTS][TRACKING_TREND_STEPS] = {};
+    auto historyNext = uint8_t{0};
+    auto historyCount = uint8_t{0};
+    auto stepTime = uint32_t{0};
+
+    /**
+    * @brief Loads the alarm limits from EEPROM, or the defaults if EEPROM holds none.
+    *
+    */
+    void setup(void) {
+        EEPROM.get(EEPROM_TRACKING, limits);
+        if (limits.crc != Crc16::compute(reinterpret_cast<uint8_t*>(&limits), crc_length)) {
+            limits.limit = LIMIT_TRACKING_ERROR;
+            limits.hysteresis = LIMIT_HYSTERESIS_TRACKING;
+        }
+        stepTime = millis();
+    }
+
+    /**
+    * @brief Adds a set of readings to the filtered tracking errors and checks the alarms.
+    *
+    * @param values   Array of readings indexed by MONITOR_SELECT_GROUP + output
+    *
+    * @return True while the tracking alarm of any output is raised
+    */
+    bool record(const int16_t values[]) {
+        const int16_t reference = values[MONITOR_VOLTAGE];
+        const int16_t magnitude0 = (reference < 0) ? -reference : reference;
+        for (auto output = uint8_t{1}; output < MONITOR_OUTPUTS; output++) {
+            const int16_t voltage = values[MONITOR_VOLTAGE + output];
+            const int16_t sample = magnitude0 - ((voltage < 0) ? -voltage : voltage);
+            int32_t &mean = filtered[output - 1];
+            if (!started) {
+                mean = static_cast<int32_t>(sample) << TRACKING_FILTER_SHIFT;
+            }
+            else {
+                mean += sample - (mean >> TRACKING_FILTER_SHIFT);
+            }
+
+            const uint8_t bit = 1 << (output - 1);
+            if (limits.limit == 0) {
+                alarmMask &= ~bit;
+                continue;
+            }
+            int16_t magnitude = mean >> TRACKING_FILTER_SHIFT;
+            if (magnitude < 0) {
+                magnitude = -magnitude;
+            }
+            const int16_t limit = (alarmMask & bit) ? limits.limit - limits.hysteresis : limits.limit;
+            if (magnitude > limit) {
+                alarmMask |= bit;
+            }
+            else {
+                alarmMask &= ~bit;
+            }
+        }
+        started = true;
+        return alarmMask != 0;
+    }
+
+    /**
+    * @brief Keeps the filtered errors every TRACKING_TREND_STEP ms for the trends.
+    *
+    */
+    void update(void) {
+        if (millis() - stepTime < TRACKING_TREND_STEP) {
+            return;
+        }
+        stepTime += TRACKING_TREND_STEP;
+        for (auto output = uint8_t{1}; output < MONITOR_OUTPUTS; output++) {
+            history[output - 1][historyNext] = error(output);
+        }
+        historyNext = (historyNext + 1) % TRACKING_TREND_STEPS;
+        if (historyCount < TRACKING_TREND_STEPS) {
+            historyCount++;
+        }
+    }
+
+    /**
+    * @brief Gets the filtered tracking error of an output.
+    *
+    * @param output   Output number, 1 - MONITOR_OUTPUTS - 1
+    *
+    * @return |V0| - |Vn| in millivolts; 0 if output is out of range
+    */
+    int16_t error(const uint8_t output) {
+        if (output == 0 || output >= MONITOR_OUTPUTS) {
+            return 0;
+        }
+        return filtered[output - 1] >> TRACKING_FILTER_SHIFT;
+    }
+
+    /**
+    * @brief Gets the change in the tracking error of an output over the last minute.
+    *
+    * @param output   Output number, 1 - MONITOR_OUTPUTS - 1
+    *
+    * @return Change in millivolts; 0 until the first trend step, or if output is out of range
+    */
+    int16_t trend(const uint8_t output) {
+        if (historyCount == 0 || output == 0 || output >= MONITOR_OUTPUTS) {
+            return 0;
+        }
+        const uint8_t oldest = (historyCount < TRACKING_TREND_STEPS) ? 0 : historyNext;
+        return error(output) - history[output - 1][oldest];
+    }
+
+    /**
+    * @brief Gets whether the tracking alarm of an output is raised.
+    *
+    * @param output   Output number, 1 - MONITOR_OUTPUTS - 1
+    */
+    bool alarm(const uint8_t output) {
+        return output != 0 && output < MONITOR_OUTPUTS && (alarmMask & (1 << (output - 1)));
+    }
+
+    /**
+    * @brief Gets whether the tracking alarm of any output is raised.
+    *
+    */
+    bool alarm(void) {
+        return alarmMask != 0;
+    }
+
+    /**
+    * @brief Sets the alarm limit and hysteresis, and queues them to be stored in EEPROM.
+    *
+    * Only bytes that have changed are written; EepromWriter::busy() until they are.
+    *
+    * @param limit        Greatest tracking error in millivolts; 0 for no alarm
+    * @param hysteresis   Distance back inside the limit at which the alarm clears, in millivolts
+    *
+    * @return False if the limit or hysteresis is out of range
+    */
+    bool setLimit(const int16_t limit, const int16_t hysteresis) {
+        if (limit < 0 || hysteresis < 0 || hysteresis > limit) {
+            return false;
+        }
+        limits.limit = limit;
+        limits.hysteresis = hysteresis;
+        limits.crc = Crc16::compute(reinterpret_cast<uint8_t*>(&limits), crc_length);
+        EepromWriter::put(EEPROM_TRACKING, &limits, sizeof(limits));
+        alarmMask = 0;
+        return true;
+    }
+
+    void getLimit(int16_t &limit, int16_t &hysteresis) {
+        limit = limits.limit;
+        hysteresis = limits.hysteresis;
+    }
+
+}
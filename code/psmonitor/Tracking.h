@@ -0,0 +1,46 @@
+#pragma once
+/**
+ * @file Tracking.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for the rail tracking monitor.
+ *
+ */
+
+#ifndef _TRACKING_H
+#define _TRACKING_H
+
+#include <Arduino.h>
+
+// MONITOR_OUTPUTS
+#include "MonitorTask.h"
+
+// Outputs tracked against output 0 (every other output); at least one so the arrays are not empty
+constexpr uint8_t TRACKING_OUTPUTS = (MONITOR_OUTPUTS > 1) ? MONITOR_OUTPUTS - 1 : 1;
+
+// The tracking error is filtered with a running mean weighting each set of readings 2^-TRACKING_FILTER_SHIFT
+constexpr uint8_t TRACKING_FILTER_SHIFT = 3;
+
+// The trend is the change in tracking error over TRACKING_TREND_STEPS steps of TRACKING_TREND_STEP ms (a minute)
+constexpr uint8_t TRACKING_TREND_STEPS = 6;
+constexpr uint16_t TRACKING_TREND_STEP = 10000;
+
+namespace Tracking {
+
+    void setup(void);
+    bool record(const int16_t values[]);
+    void update(void);
+
+    int16_t error(const uint8_t output);
+    int16_t trend(const uint8_t output);
+    bool alarm(const uint8_t output);
+    bool alarm(void);
+
+    bool setLimit(const int16_t limit, const int16_t hysteresis);
+    void getLimit(int16_t &limit, int16_t &hysteresis);
+
+}
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file Watchdog.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Supervises the scheduler loop with the AVR watchdog, and records reset causes and task overruns.
+ *
+ * The scheduler brackets each task with start() and finish(); a task that takes longer than
+ * its budget is counted as an overrun. The watchdog is fed at the end of each pass of the
+ * loop only if every task finished within its budget, so a task that blocks (e.g. Wire
+ * waiting on a hung I2C bus) or keeps overrunning stops the feeding and the watchdog
+ * resets the processor rather than leaving stale readings on the display.
+ *
+ * The watchdog runs in interrupt and reset mode: the first timeout raises an interrupt that
+ * notes the stalled task in RAM that is not cleared at startup, and the second resets the
+ * processor; the note is written to EEPROM after the reset (or on recovery), not by the
+ * interrupt. The cause of each reset is recorded at startup, with a count of resets by
+ * cause and of overruns by task. Overrun counts are written to EEPROM at most once every WATCHDOG_SAVE_INTERVAL.
+ *
+ * Note: the Optiboot bootloader clears the reset flags before the sketch starts, so with
+ * Optiboot only watchdog resets (noted by the interrupt) are told apart from others.
+ *
+ * To use the watchdog:
+ *      - Watchdog::setup() - record the reset cause; call early in setup()
+ *      - Watchdog::enable() - start the watchdog
+ *      - Watchdog::wait() - pause in setup() for longer than the watchdog timeout
+ *      - Watchdog::start() / Watchdog::finish() - bracket each task run by the scheduler
+ *      - Watchdog::update() - feed the watchdog; call at the end of each pass of the loop
+ *      - Watchdog::lastCause(), Watchdog::stalledTask(), Watchdog::resets(), Watchdog::overruns() - records
+ *      - Watchdog::causeName(), Watchdog::taskName() - names for display
+ */
+
+// Include standard headers as needed
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <EEPROM.h>
+#include <stddef.h>
+
+// Include our own header file
+#include "Watchdog.h"
+
+// EEPROM layout and CRC used to validate EEPROM data
+#include "eeprom_map.h"
+#include "Crc16.h"
+
+// Reset flags, saved before they are cleared early in startup
+uint8_t resetFlags __attribute__((section(".noinit")));
+
+// Task running at the last watchdog timeout, and its check byte (the task XOR STALL_MARKER);
+// set by the interrupt and kept over the reset that follows. After power up both hold
+// whatever the RAM came up with, which the check rejects.
+volatile uint8_t stallTask __attribute__((section(".noinit")));
+volatile uint8_t stallCheck __attribute__((section(".noinit")));
+
+/**
+* @brief Saves and clears the reset flags and stops the watchdog; runs before the C++ runtime starts.
+*
+* After a watchdog reset the watchdog stays enabled with its shortest timeout, so it must be
+* stopped before static initialization and setup() have a chance to run.
+*/
+void saveResetFlags(void) __attribute__((naked, used, section(".init3")));
+void saveResetFlags(void) {
+    resetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+namespace Watchdog {
+
+    // Minimum time between EEPROM writes of the overrun counts
+    constexpr uint32_t WATCHDOG_SAVE_INTERVAL = 60000;
+
+    // Check byte pattern of the stall note
+    constexpr uint8_t STALL_MARKER = 0xA5;
+
+    // Time between feeds while waiting in wait(); well inside the timeout
+    constexpr uint16_t WATCHDOG_WAIT_STEP = 100;
+
+    // Time budget of each task (WATCHDOG_TASK) in milliseconds. Settings saved by serial
+    // commands and button actions are written by EepromWriter, a byte each pass, so no task
+    // waits on an EEPROM write; a benchmark (one per pass) takes a few milliseconds.
+    const uint16_t budgets[TASK_COUNT] PROGMEM = {50, 50, 50, 50, 50, 50, 50};
+
+    // Record kept in EEPROM
+    struct watchdog_record {
+        uint8_t lastCause;              // RESET_CAUSE
+        uint8_t stalledTask;            // WATCHDOG_TASK running at the last watchdog timeout
+        uint8_t reserved[2];
+        uint16_t resets[RESET_CAUSES];  // Resets by cause; saturate
+        uint16_t overruns[TASK_COUNT];  // Overruns by task; saturate
+        uint16_t crc;
+    };
+    constexpr uint16_t crc_length = offsetof(watchdog_record, crc);
+    static_assert(sizeof(watchdog_record) <= EEPROM_WATCHDOG_END - EEPROM_WATCHDOG, "Watchdog record must fit in its EEPROM space");
+
+    watchdog_record record;
+
+    // Supervision of the pass in progress
+    volatile uint8_t currentTask = TASK_NONE;
+    auto taskStart = uint32_t{0};
+    auto overrun = bool{false};
+
+    // Deferred saving of overrun counts
+    auto overrunsDirty = bool{false};
+    auto lastSave = uint32_t{0};
+
+    // Names for display
+    const char causeUnknown[] PROGMEM = "UNKNOWN";
+    const char causePowerOn[] PROGMEM = "POWER ON";
+    const char causeExternal[] PROGMEM = "EXTERNAL";
+    const char causeBrownOut[] PROGMEM = "BROWN OUT";
+    const char causeWatchdog[] PROGMEM = "WATCHDOG";
+    const char *const causeNames[RESET_CAUSES] PROGMEM = {causeUnknown, causePowerOn, causeExternal, causeBrownOut, causeWatchdog};
+
+    const char taskButton[] PROGMEM = "BUTTON";
+    const char taskSerial[] PROGMEM = "SERIAL";
+    const char taskMonitor[] PROGMEM = "MONITOR";
+    const char taskRipple[] PROGMEM = "RIPPLE";
+    const char taskCapture[] PROGMEM = "CAPTURE";
+    const char taskStep[] PROGMEM = "STEP";
+    const char taskCalibrate[] PROGMEM = "CALIBRATE";
+    const char taskNone[] PROGMEM = "NONE";
+    const char *const taskNames[TASK_COUNT + 1] PROGMEM = {taskButton, taskSerial, taskMonitor, taskRipple,
+                                                           taskCapture, taskStep, taskCalibrate, taskNone};
+
+    // Forward declarations of functions used only in this module
+    namespace
+    {
+
+      bool takeStall(void);
+      void save(void);
+      void increment(uint16_t &count);
+
+    }
+
+    /**
+    * @brief Records the cause of the last reset.
+    *
+    */
+    void setup(void) {
+        EEPROM.get(EEPROM_WATCHDOG, record);
+        if (record.crc != Crc16::compute(reinterpret_cast<uint8_t*>(&record), crc_length)) {
+            memset(&record, 0, sizeof(record));
+            record.stalledTask = TASK_NONE;
+        }
+
+        uint8_t cause = RESET_UNKNOWN;
+        if (takeStall() || (resetFlags & bit(WDRF))) {
+            cause = RESET_WATCHDOG;
+        }
+        else if (resetFlags & bit(BORF)) {
+            cause = RESET_BROWN_OUT;
+        }
+        else if (resetFlags & bit(EXTRF)) {
+            cause = RESET_EXTERNAL;
+        }
+        else if (resetFlags & bit(PORF)) {
+            cause = RESET_POWER_ON;
+        }
+        record.lastCause = cause;
+        increment(record.resets[cause]);
+        save();
+    }
+
+    /**
+    * @brief Starts the watchdog with a 1 second timeout.
+    *
+    */
+    void enable(void) {
+        // Interrupt and reset mode; the timed sequence must not be interrupted
+        cli();
+        wdt_reset();
+        WDTCSR = bit(WDCE) | bit(WDE);
+        WDTCSR = bit(WDIE) | bit(WDE) | bit(WDP2) | bit(WDP1);
+        sei();
+    }
+
+    /**
+    * @brief Waits, feeding the watchdog; for pauses in setup() (e.g. to show a message).
+    *
+    * @param ms   Time to wait in milliseconds
+    */
+    void wait(const uint16_t ms) {
+        for (auto waited = uint16_t{0}; waited < ms; waited += WATCHDOG_WAIT_STEP) {
+            wdt_reset();
+            delay(WATCHDOG_WAIT_STEP);
+        }
+        wdt_reset();
+    }
+
+    /**
+    * @brief Marks the start of a task run.
+    *
+    * @param task   WATCHDOG_TASK
+    */
+    void start(const uint8_t task) {
+        currentTask = task;
+        taskStart = millis();
+    }
+
+    /**
+    * @brief Marks the end of the task run; counts an overrun if the task took longer than its budget.
+    *
+    */
+    void finish(void) {
+        if (millis() - taskStart > pgm_read_word(&budgets[currentTask])) {
+            overrun = true;
+            increment(record.overruns[currentTask]);
+            overrunsDirty = true;
+        }
+        currentTask = TASK_NONE;
+    }
+
+    /**
+    * @brief Feeds the watchdog if every task finished within its budget during this pass.
+    *
+    * Also saves changed overrun counts, at most once every WATCHDOG_SAVE_INTERVAL.
+    */
+    void update(void) {
+        if (!overrun) {
+            wdt_reset();
+            if (takeStall()) {
+                // Recovered after the first timeout; resume interrupt and reset mode
+                save();
+                WDTCSR |= bit(WDIE);
+            }
+        }
+        overrun = false;
+
+        if (overrunsDirty && millis() - lastSave >= WATCHDOG_SAVE_INTERVAL) {
+            save();
+        }
+    }
+
+    uint8_t lastCause(void) {
+        return record.lastCause;
+    }
+
+    uint8_t stalledTask(void) {
+        return record.stalledTask;
+    }
+
+    uint16_t resets(const uint8_t cause) {
+        return (cause < RESET_CAUSES) ? record.resets[cause] : 0;
+    }
+
+    uint16_t overruns(const uint8_t task) {
+        return (task < TASK_COUNT) ? record.overruns[task] : 0;
+    }
+
+    const __FlashStringHelper *causeName(const uint8_t cause) {
+        return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&causeNames[(cause < RESET_CAUSES) ? cause : uint8_t{RESET_UNKNOWN}]));
+    }
+
+    const __FlashStringHelper *taskName(const uint8_t task) {
+        return reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&taskNames[(task < TASK_COUNT) ? task : uint8_t{TASK_NONE}]));
+    }
+
+    // Functions used only in this module
+    namespace
+    {
+
+      /**
+      * @brief Moves the task noted by the watchdog interrupt, if any, into the record.
+      *
+      * @return True if the watchdog timed out since the note was last taken
+      */
+      bool takeStall(void) {
+          if (stallCheck != (stallTask ^ STALL_MARKER) || stallTask > TASK_NONE) {
+              return false;
+          }
+          record.stalledTask = stallTask;
+          stallCheck = ~stallCheck;
+          return true;
+      }
+
+      /**
+      * @brief Writes the record to EEPROM; only changed bytes are written.
+      *
+      */
+      void save(void) {
+          record.crc = Crc16::compute(reinterpret_cast<uint8_t*>(&record), crc_length);
+          EEPROM.put(EEPROM_WATCHDOG, record);
+          overrunsDirty = false;
+          lastSave = millis();
+      }
+
+      void increment(uint16_t &count) {
+          if (count != UINT16_MAX) {
+              count++;
+          }
+      }
+
+    }
+
+}
+
+/**
+* @brief Watchdog timeout interrupt handler; notes the stalled task before the reset that follows.
+*
+* The watchdog resets the processor at its next timeout unless the loop recovers and feeds it.
+* Only RAM is written here: an EEPROM write would hold the interrupt for milliseconds.
+*/
+ISR(WDT_vect) {
+    using namespace Watchdog;
+    stallTask = currentTask;
+    stallCheck = currentTask ^ STALL_MARKER;
+}
@@ -0,0 +1,58 @@
+#pragma once
+/**
+ * @file Watchdog.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file for watchdog supervision of the scheduler loop.
+ *
+ */
+
+#ifndef _WATCHDOG_H
+#define _WATCHDOG_H
+
+#include <Arduino.h>
+
+// Scheduled tasks supervised by the watchdog
+enum WATCHDOG_TASK : uint8_t {
+    TASK_BUTTON,
+    TASK_SERIAL,
+    TASK_MONITOR,
+    TASK_RIPPLE,
+    TASK_CAPTURE,
+    TASK_STEP,
+    TASK_CALIBRATE,
+    TASK_COUNT,
+    TASK_NONE = TASK_COUNT,     // Between tasks
+};
+
+// Causes of the last reset
+enum RESET_CAUSE : uint8_t {
+    RESET_UNKNOWN,      // Cleared by the bootloader
+    RESET_POWER_ON,
+    RESET_EXTERNAL,     // Reset pin (or the serial port opening)
+    RESET_BROWN_OUT,
+    RESET_WATCHDOG,     // A task stalled
+    RESET_CAUSES,
+};
+
+namespace Watchdog {
+
+    void setup(void);
+    void enable(void);
+    void wait(const uint16_t ms);
+    void start(const uint8_t task);
+    void finish(void);
+    void update(void);
+
+    uint8_t lastCause(void);
+    uint8_t stalledTask(void);
+    uint16_t resets(const uint8_t cause);
+    uint16_t overruns(const uint8_t task);
+    const __FlashStringHelper *causeName(const uint8_t cause);
+    const __FlashStringHelper *taskName(const uint8_t task);
+
+}
+
+#endif
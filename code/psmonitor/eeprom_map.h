@@ -0,0 +1,31 @@
+#pragma once
+/**
+ * @file eeprom_map.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Header file defining where each persistent record lives in EEPROM.
+ *
+ */
+
+#ifndef _EEPROM_MAP_H
+#define _EEPROM_MAP_H
+
+// Start addresses of the records kept in the 1KB EEPROM
+enum EEPROM_ADDRESS : int16_t {
+    EEPROM_CALIBRATION = 0,                 // Calibration data of earlier firmware (Calibration::cal_data, 26 bytes)
+    EEPROM_ALERT_RULES = 64,                // Alert rule table (Alerts::rule_table, 8 bytes per rule + 2)
+    EEPROM_ALERT_RULES_END = 160,
+    EEPROM_CALIBRATION_DIRECTORY = 160,     // Calibration profile directory (Calibration::cal_directory, 4 bytes)
+    EEPROM_CALIBRATION_PROFILES = 176,      // Calibration profiles (Calibration::cal_profile, CALIBRATION_PROFILE_SIZE bytes each)
+    EEPROM_CALIBRATION_PROFILES_END = 320,
+    EEPROM_WATCHDOG = 320,                  // Reset causes and task overruns (Watchdog::watchdog_record, 28 bytes)
+    EEPROM_WATCHDOG_END = 352,
+    EEPROM_EVENT_LOG = 352,                 // Over-limit event ring (event_entry, 12 bytes each)
+    EEPROM_EVENT_LOG_END = 832,
+    EEPROM_TRACKING = 832,                  // Rail tracking alarm limits (Tracking::tracking_limits, 6 bytes)
+    EEPROM_TRACKING_END = 848,
+};
+
+#endif
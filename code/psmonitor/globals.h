@@ -15,10 +15,24 @@
 #ifndef _GLOBALS_H
 #define _GLOBALS_H
 
-/// Array of integers holding a set of current and voltage measurements
-extern int16_t readings[4];
-
 /// Buffer used to construct strings displayed on LCD monitor
 extern char string_buf[17];
 
+/// Operating modes
+enum STATE : uint8_t {
+  MODE_NORMAL,
+  MODE_CALIBRATE,
+  MODE_TERMINATE,
+  MODE_RIPPLE,
+  MODE_CAPTURE,
+  MODE_STEP,
+  MODE_COUNT,
+};
+
+/// Current operating mode; change with changeMode()
+extern uint8_t currentMode;
+
+/// Switches between the measurement modes (normal, ripple, capture, step); false if not possible now
+bool changeMode(const uint8_t mode);
+
 #endif
@@ -7,6 +7,9 @@
  *
  * @brief Header file defining maximum specs for a monitored power supply.
  *
+ * These are the defaults for the alert rules; the rules themselves can be changed
+ * at runtime (see Alerts.cpp).
+ *
  */
  
 #ifndef _LIMITS_H
@@ -16,5 +19,10 @@
 enum LIMITS : int16_t {
     LIMIT_MAX_VOLTAGE = 15000,  // Voltage limits in millivolts
     LIMIT_MAX_CURRENT = 1000,   // Current limit in milliamps
+    LIMIT_HYSTERESIS_VOLTAGE = 100,  // Voltage alert hysteresis in millivolts
+    LIMIT_HYSTERESIS_CURRENT = 20,   // Current alert hysteresis in milliamps
+    LIMIT_TRIP_CURRENT = 1100,  // Current at which the protection output trips, in milliamps
+    LIMIT_TRACKING_ERROR = 250,         // Greatest difference between |V0| and |Vn| (Tracking.cpp), in millivolts
+    LIMIT_HYSTERESIS_TRACKING = 50,     // Tracking alarm hysteresis in millivolts
 };
 #endif
@@ -33,11 +33,26 @@
 // Include task header files
 #include "globals.h"
 #include "BuzzerTask.h"
+#include "ButtonTask.h"
 #include "CalibrateTask.h"
 #include "MonitorTask.h"
+#include "RippleTask.h"
+#include "CaptureTask.h"
+#include "StepTask.h"
+#include "Histogram.h"
+#include "EventLog.h"
+#include "EepromWriter.h"
+#include "Benchmark.h"
+#include "Watchdog.h"
+#include "SerialTask.h"
 
 // Project specific headers
+#include "Alerts.h"
 #include "Calibration.h"
+#include "Glyphs.h"
+#include "Protection.h"
+#include "Tracking.h"
+#include "limits.h"
 
 // Create an LCD object.
 // Initialize the library by mapping any LCD interface pins to the
@@ -49,24 +64,24 @@ LiquidCrystal lcd(RS, EN, D2, D3, D4, D5);
 enum DIGITAL_PINS : uint8_t {
     BUZZER_PIN = 6,
     BUTTON_PIN = 7,
+    TRIP_PIN = 8,              // Protection relay/crowbar output
+    ALERT_POS_PIN = A0,        // Positive sensor ALERT input
+    ALERT_NEG_PIN = A1,        // Negative sensor ALERT input (isolated)
 };
 
 // Various useful state values
-uint8_t previous_button_state = HIGH;
-enum STATE : uint8_t {
-  MODE_NORMAL,
-  MODE_CALIBRATE,
-  MODE_TERMINATE,
-};
 uint8_t currentMode = MODE_NORMAL;
 
 // Monitor task configuration
-enum MONITOR_CFG : uint32_t {MONITOR_INTERVAL = 200};  // Time between runs; in milliseconds
-enum MONITOR_ADR : uint8_t {
-    MONITOR_POS_ADDR = 0x40,  // I2C address of positive voltage/current sensor
-    MONITOR_NEG_ADDR = 0x41,  // I2C address of negative voltage/current sensor
+enum MONITOR_CFG : uint32_t {MONITOR_INTERVAL = 200};  // Time between display updates; in milliseconds
+const monitor_output monitorOutputs[MONITOR_OUTPUTS] PROGMEM = {
+    {0x40, false, '+', ALERT_POS_PIN},    // Positive output: I2C address of its voltage/current sensor, label, ALERT input
+    {0x41, true, '-', ALERT_NEG_PIN},     // Negative output
 };
 
+// Serial port speed for configuration commands
+enum SERIAL_CFG : uint32_t {SERIAL_BAUD = 115200};
+
 // Buffer for string manipulation; global
 char string_buf[17] = {};
 
@@ -76,21 +91,52 @@ char string_buf[17] = {};
 */
 void setup() {
     // initialize digital pin LED_BUILTIN as an output.
-    pinMode(BUTTON_PIN, INPUT);
     pinMode(BUZZER_PIN, OUTPUT);
     pinMode(LED_BUILTIN, OUTPUT);
 
+    // Record the cause of this reset, and supervise the rest of setup and the scheduler loop
+    Watchdog::setup();
+    Watchdog::enable();
+    Benchmark::bootMark(BOOT_WATCHDOG);
+
+    // Start the cycle counter, if the scheduler loop is profiled
+    Benchmark::setup();
+
+    // Note any over-current ALERT the sensors latched before this reset; setting them up releases it
+    Protection::sample(monitorOutputs);
+
+    // Setup the monitor task before the LCD, so the sensors are converting while the
+    // LCD initializes
+    MonitorTask::setup(MONITOR_INTERVAL, monitorOutputs, &lcd);
+    Benchmark::bootMark(BOOT_SENSORS);
+
     // set up the LCD's number of columns and rows and clear the screen:
     lcd.begin(16, 2);
     lcd.clear();
+    Glyphs::setup(&lcd);
+    Benchmark::bootMark(BOOT_LCD);
+
+    // Show the cause of this reset if something went wrong
+    if (Watchdog::lastCause() == RESET_WATCHDOG || Watchdog::lastCause() == RESET_BROWN_OUT) {
+        lcd.print(F("Reset: "));
+        lcd.print(Watchdog::causeName(Watchdog::lastCause()));
+        if (Watchdog::lastCause() == RESET_WATCHDOG) {
+            lcd.setCursor(0, 1);
+            lcd.print(F("In: "));
+            lcd.print(Watchdog::taskName(Watchdog::stalledTask()));
+        }
+        Watchdog::wait(2000);
+        lcd.clear();
+    }
 
     // Setup the buzzer task
     BuzzerTask::setup(BUZZER_PIN, HIGH, LOW);
 
-    // Setup the monitor task
-    MonitorTask::setup(MONITOR_INTERVAL,
-                       MONITOR_POS_ADDR,
-                       MONITOR_NEG_ADDR, &lcd);
+    // Setup the button task; starts capturing button edges
+    ButtonTask::setup(BUTTON_PIN);
+
+    // Setup the serial task; accepts configuration commands
+    SerialTask::setup(SERIAL_BAUD);
 
     // Can monitor task communicate with sensors?
     if (!MonitorTask::communicationOK()) {
@@ -98,63 +144,168 @@ void setup() {
 		    lcd.print(F("Fault!"));
         lcd.setCursor(0, 1);
         lcd.print(F("Sensor Comm Bad?"));
-        BuzzerTask::beep(BEEP_LONG, 3);
+        BuzzerTask::play(PATTERN_FAULT);
         currentMode = MODE_TERMINATE;
     }
     else {
       
-        // Initialize monitoring hardware
-        MonitorTask::setAveragingCount(INA260_COUNT_16);
-        MonitorTask::setConversionTime(INA260_TIME_2_116_ms);
-
-        // Setup the Calibrate task
+        // Setup the Calibrate and Ripple tasks
         CalibrateTask::setup(&lcd);
+        RippleTask::setup(&lcd);
+        CaptureTask::setup(&lcd);
+        StepTask::setup(&lcd);
+        Benchmark::bootMark(BOOT_TASKS);
 
         // Read existing calibration data, if any
         Calibration::recall();
+        Benchmark::bootMark(BOOT_CALIBRATION);
+
+        // Read alert rules and the rail tracking limit, and find the newest logged over-limit event
+        Alerts::setup();
+        Tracking::setup();
+        EventLog::setup();
+
+        // Arm the over-current trip; fails if an output's ALERT pin is not on the port its interrupt handles
+        if (!Protection::setup(TRIP_PIN, monitorOutputs, LIMIT_TRIP_CURRENT)) {
+            lcd.setCursor(5, 0);
+            lcd.print(F("Fault!"));
+            lcd.setCursor(0, 1);
+            lcd.print(F("ALERT Pins Bad? "));
+            BuzzerTask::play(PATTERN_FAULT);
+            currentMode = MODE_TERMINATE;
+            return;
+        }
+        Benchmark::bootMark(BOOT_ALERTS);
 
         // Check the mute/calibrate button; if low at powerup, then set calibrate mode
         if (digitalRead(BUTTON_PIN) == LOW) {
-            previous_button_state = LOW;
-            BuzzerTask::beep(BEEP_MEDIUM, 2);
+            BuzzerTask::play(PATTERN_CALIBRATE);
             currentMode = MODE_CALIBRATE;
         }
         // If mute/calibrate button not being held down, just beep
         else {
-            BuzzerTask::beep(BEEP_SHORT, 1);
+            BuzzerTask::play(PATTERN_READY);
         }
+
+        // Initialize monitoring hardware: 16 averaged 2.116ms conversions. In normal mode
+        // a first reading is shown from the sensors' quick power-on configuration first.
+        MonitorTask::setConfiguration(INA260_COUNT_16, INA260_TIME_2_116_ms, currentMode == MODE_NORMAL);
     }
 }
 
 
+/**
+* @brief Switches between the measurement modes (normal, ripple and capture).
+*
+* Stops the task for the current mode and starts the task for the new one. Only possible
+* once setup is complete and calibration (if any) has finished.
+*
+* @param mode   The new mode (STATE)
+*
+* @return False if the mode cannot be changed now
+*/
+bool changeMode(const uint8_t mode) {
+    if (currentMode == MODE_TERMINATE || currentMode == MODE_CALIBRATE ||
+        (mode != MODE_NORMAL && mode != MODE_RIPPLE && mode != MODE_CAPTURE && mode != MODE_STEP)) {
+        return false;
+    }
+    if (mode == currentMode) {
+        return true;
+    }
+
+    if (currentMode == MODE_RIPPLE) {
+        RippleTask::stop();
+    }
+    else if (currentMode == MODE_CAPTURE) {
+        CaptureTask::stop();
+    }
+    else if (currentMode == MODE_STEP) {
+        StepTask::stop();
+    }
+    lcd.clear();
+    if (mode == MODE_RIPPLE) {
+        RippleTask::start();
+    }
+    else if (mode == MODE_CAPTURE) {
+        CaptureTask::start();
+    }
+    else if (mode == MODE_STEP) {
+        StepTask::start();
+    }
+    currentMode = mode;
+    return true;
+}
+
+
 /**
 * @brief Runs continuously after setup; implements a simple non-preempting round-robin scheduler.
 *
 */
 void loop() {
-    // Check mute/calibrate button; toggle mute mode if button state has
-    // transitioned from from HIGH to LOW since last check ("edge" triggered)
-    if (digitalRead(BUTTON_PIN) == LOW) {
-        if (previous_button_state == HIGH) {
-            previous_button_state = LOW;
-            switch(currentMode) {
-            case MODE_CALIBRATE:
-                BuzzerTask::beep(BEEP_BLIP, 1);
-                CalibrateTask::buttonPress(); // Inform the calibrate task that button was pushed
-                break;
-            case MODE_NORMAL:
-            default:
-                BuzzerTask::toggleMute();
-                break;
-            }
+    // Count the cycles taken by each pass, by operating mode (only if BENCHMARK_LOOP_PROFILING)
+    Benchmark::loopMark(currentMode);
+
+    // Classify any button edges captured since the last time through the loop,
+    // then act on a click: toggle mute, or advance calibration.
+    Watchdog::start(TASK_BUTTON);
+    ButtonTask::update();
+    switch(ButtonTask::getEvent()) {
+    case BUTTON_CLICK:
+        switch(currentMode) {
+        case MODE_CALIBRATE:
+            BuzzerTask::play(PATTERN_BUTTON);
+            CalibrateTask::buttonPress(); // Inform the calibrate task that button was pushed
+            break;
+        case MODE_NORMAL:
+        default:
+            BuzzerTask::toggleMute();
+            break;
         }
+        break;
+    case BUTTON_DOUBLE_CLICK:
+        // Show the next display page, re-arm the capture, or show the other output's step
+        if (currentMode == MODE_NORMAL) {
+            MonitorTask::nextPage();
+        }
+        else if (currentMode == MODE_RIPPLE) {
+            RippleTask::nextPage();
+        }
+        else if (currentMode == MODE_CAPTURE) {
+            CaptureTask::arm();
+        }
+        else if (currentMode == MODE_STEP) {
+            StepTask::nextPage();
+        }
+        break;
+    case BUTTON_LONG_PRESS:
+        // Reset the over-current trip, if it has tripped; otherwise clear the load
+        // profile, show an older event, or switch calibration profile, when shown
+        if (Protection::tripped()) {
+            BuzzerTask::play(Protection::reset() ? PATTERN_BUTTON : PATTERN_FAULT);
+        }
+        else if (currentMode == MODE_NORMAL && MonitorTask::page() == PAGE_HISTOGRAM) {
+            Histogram::reset();
+            BuzzerTask::play(PATTERN_BUTTON);
+        }
+        else if (currentMode == MODE_NORMAL && MonitorTask::page() == PAGE_EVENTS) {
+            MonitorTask::nextEvent();
+            BuzzerTask::play(PATTERN_BUTTON);
+        }
+        else if (currentMode == MODE_NORMAL && MonitorTask::page() == PAGE_PROFILE) {
+            BuzzerTask::play(Calibration::nextProfile() ? PATTERN_BUTTON : PATTERN_FAULT);
+        }
+        break;
+    case BUTTON_NONE:
+    default:
+        break;
     }
-    else {
-        previous_button_state = HIGH;
-    }
 
-    // Process any requested buzzer soundings
-    BuzzerTask::update();
+    Watchdog::finish();
+
+    // Process any commands received over the serial port
+    Watchdog::start(TASK_SERIAL);
+    SerialTask::update();
+    Watchdog::finish();
 
     // Dispatch to monitor or calibrate task, depending on current operational mode.
     switch(currentMode) {
@@ -163,17 +314,46 @@ void loop() {
     case MODE_CALIBRATE:
         if (CalibrateTask::finished()) {
             currentMode = MODE_NORMAL;
-            BuzzerTask::beep(BEEP_BLIP, 3); // Let the user know calbration is done
+            BuzzerTask::play(PATTERN_CALIBRATED); // Let the user know calbration is done
             break;
         }
+        Watchdog::start(TASK_CALIBRATE);
         CalibrateTask::update();
         Calibration::recall();
+        Watchdog::finish();
+        break;
+    case MODE_RIPPLE:
+        // Measure and display ripple and noise
+        Watchdog::start(TASK_RIPPLE);
+        RippleTask::update();
+        Watchdog::finish();
+        break;
+    case MODE_CAPTURE:
+        // Record a transient around the trigger
+        Watchdog::start(TASK_CAPTURE);
+        CaptureTask::update();
+        Watchdog::finish();
+        break;
+    case MODE_STEP:
+        // Measure the response to load steps
+        Watchdog::start(TASK_STEP);
+        StepTask::update();
+        Watchdog::finish();
         break;
     case MODE_NORMAL:
     default:
-        // Read and display voltage and current readings.
-        // This takes on the order of 15ms elapsed time.
+        // Read voltage and current readings as the sensors convert them, and display
+        // their means. A display update takes on the order of 15ms elapsed time.
+        Watchdog::start(TASK_MONITOR);
         MonitorTask::update();
+        Watchdog::finish();
         break;
     }
+
+    // Write logged over-limit events and saved settings to EEPROM, a byte at a time
+    EventLog::update();
+    EepromWriter::update();
+
+    // Feed the watchdog if every task ran within its budget
+    Watchdog::update();
  }
@@ -0,0 +1,115 @@
+/**
+ * @file bench.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host build of the routines timed by DIAG:BENCH?, for comparing changes without the hardware.
+ *
+ * Each routine is called through a function pointer CALLS times with inputs the compiler
+ * cannot see, as Benchmark.cpp does on the AVR; the fastest of RUNS runs, less the cost of an
+ * empty call, is reported in nanoseconds per call. Host times only rank changes against each
+ * other: the AVR has no multiplier wider than 8 bits or divider, so its costs differ in kind.
+ *
+ * The output is a row for the host table in docs/benchmarks.md; the first argument, if any,
+ * is the commit measured. The sensors are not used: their constructor is a stand-in.
+ */
+
+#include <chrono>
+#include <stdio.h>
+
+#include "Adafruit_INA260.h"
+#include "Calibration.h"
+#include "Crc16.h"
+#include "Fixed.h"
+#include "MonitorTask.h"
+
+// Formatting buffer shared between tasks, defined by the sketch
+char string_buf[17] = {};
+
+namespace {
+
+    constexpr uint32_t CALLS = 1000000;
+    constexpr uint8_t RUNS = 5;
+
+    // Inputs and result; volatile so each call is made in full
+    volatile int16_t input16 = 12345;
+    volatile fixed inputFixed = Fixed::int2fixed(3) + Fixed::fixed_one / 3;
+    volatile int32_t sink;
+    uint8_t crcData[16] = {};
+
+    void empty(void) {
+        sink = input16;
+    }
+
+    void nearest10(void) {
+        sink = MonitorTask::nearest10(input16);
+    }
+
+    void voltageString(void) {
+        sink = MonitorTask::generateVoltageString(input16)[0];
+    }
+
+    void multiply(void) {
+        sink = Fixed::multiply(inputFixed, inputFixed);
+    }
+
+    void invert(void) {
+        sink = Fixed::invert(inputFixed);
+    }
+
+    void correct(void) {
+        sink = Calibration::correct(MONITOR_CURRENT, input16);
+    }
+
+    void crc16(void) {
+        sink = Crc16::compute(crcData, sizeof(crcData));
+    }
+
+    void scaleCurrent(void) {
+        // As Adafruit_INA260::readCurrentInt16(), less the I2C transfer
+        const int16_t value = input16;
+        sink = value + (value >> 2);
+    }
+
+    // Routines in the column order of docs/benchmarks.md
+    void (*const routines[])(void) = {nearest10, voltageString, multiply, invert, correct, crc16, scaleCurrent};
+
+    /**
+    * @brief Times CALLS calls of a routine, RUNS times.
+    *
+    * @param body   Makes one call of the routine
+    *
+    * @return Fewest nanoseconds per call of any run, including the cost of the call
+    */
+    double timeCalls(void (*body)(void)) {
+        auto fewest = 1e9;
+        for (auto run = uint8_t{0}; run < RUNS; run++) {
+            const auto start = std::chrono::steady_clock::now();
+            for (auto n = uint32_t{0}; n < CALLS; n++) {
+                body();
+            }
+            const std::chrono::duration<double, std::nano> taken = std::chrono::steady_clock::now() - start;
+            if (taken.count() / CALLS < fewest) {
+                fewest = taken.count() / CALLS;
+            }
+        }
+        return fewest;
+    }
+
+}
+
+// Stand-in for the sensor driver, which is not built for the host
+Adafruit_INA260::Adafruit_INA260(void) {}
+
+int main(int argc, char *argv[]) {
+    Calibration::recall();
+    const double overhead = timeCalls(empty);
+    printf("| %s |", (argc > 1) ? argv[1] : "");
+    for (auto body : routines) {
+        const double taken = timeCalls(body) - overhead;
+        printf(" %.1f |", (taken > 0) ? taken : 0.0);
+    }
+    printf("\n");
+    return 0;
+}
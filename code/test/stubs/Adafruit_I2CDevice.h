@@ -0,0 +1,5 @@
+#pragma once
+// Host stand-in: the sensor driver's declarations only need the type
+#include <Wire.h>
+
+class Adafruit_I2CDevice;
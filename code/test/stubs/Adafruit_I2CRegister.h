@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in: the sensor driver's declarations only need the types
+#include <Adafruit_I2CDevice.h>
+
+class Adafruit_I2CRegister;
+class Adafruit_I2CRegisterBits;
@@ -0,0 +1,54 @@
+/**
+ * @file Arduino.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host stand-in for the AVR registers and Arduino core functions in Arduino.h.
+ *
+ */
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+EEPROMClass EEPROM;
+
+volatile uint8_t PORTB, PORTC, PORTD;
+volatile uint8_t PINB, PINC, PIND;
+volatile uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIMSK2;
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    // The pull-up is the output bit of an input pin
+    if (mode == INPUT_PULLUP) {
+        digitalWrite(pin, HIGH);
+    }
+    else if (mode == INPUT) {
+        digitalWrite(pin, LOW);
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    volatile uint8_t *port = portOutputRegister(digitalPinToPort(pin));
+    if (value == HIGH) {
+        *port |= digitalPinToBitMask(pin);
+    }
+    else {
+        *port &= ~digitalPinToBitMask(pin);
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return (*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+void delayMicroseconds(unsigned int) {
+}
+
+unsigned long millis(void) {
+    return 0;
+}
+
+unsigned long micros(void) {
+    return 0;
+}
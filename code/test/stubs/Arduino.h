@@ -0,0 +1,86 @@
+#pragma once
+/**
+ * @file Arduino.h
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host stand-in for the parts of the Arduino core used by the modules under test.
+ *
+ * AVR registers are plain variables (defined in Arduino.cpp), so a test can inspect the
+ * output pins or the interrupt enables, drive the input pins, and call interrupt handlers itself.
+ */
+
+#ifndef _ARDUINO_H
+#define _ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <avr/interrupt.h>
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define F_CPU 16000000UL
+#define bit(b) (1UL << (b))
+#define constrain(value, low, high) ((value) < (low) ? (low) : ((value) > (high) ? (high) : (value)))
+
+// Strings in program memory are ordinary strings
+class __FlashStringHelper;
+#define F(string) (reinterpret_cast<const __FlashStringHelper*>(string))
+
+// Output through a Print (e.g. the display) is discarded
+class Print {
+public:
+    template <typename T> size_t print(T) { return 0; }
+    template <typename T> size_t println(T) { return 0; }
+    size_t write(uint8_t) { return 0; }
+};
+
+// Pins as on the Uno/Nano: 0 - 7 on PORTD, 8 - 13 on PORTB, 14 - 19 (A0 - A5) on PORTC
+enum : uint8_t { A0 = 14, A1, A2, A3, A4, A5 };
+#define PB 2
+#define PC 3
+#define PD 4
+#define digitalPinToPort(p) ((p) < 8 ? PD : (p) < 14 ? PB : PC)
+#define digitalPinToBitMask(p) (static_cast<uint8_t>(1 << ((p) < 8 ? (p) : (p) < 14 ? (p) - 8 : (p) - 14)))
+#define portOutputRegister(port) ((port) == PB ? &PORTB : (port) == PC ? &PORTC : &PORTD)
+#define portInputRegister(port) ((port) == PB ? &PINB : (port) == PC ? &PINC : &PIND)
+
+// Pin change interrupts: PCINT0 is PORTB, PCINT1 PORTC, PCINT2 PORTD
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define digitalPinToPCICR(p) ((p) < 20 ? &PCICR : nullptr)
+#define digitalPinToPCICRbit(p) ((p) < 8 ? 2 : (p) < 14 ? 0 : 1)
+#define digitalPinToPCMSK(p) ((p) < 8 ? &PCMSK2 : (p) < 14 ? &PCMSK0 : &PCMSK1)
+#define digitalPinToPCMSKbit(p) ((p) < 8 ? (p) : (p) < 14 ? (p) - 8 : (p) - 14)
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void delayMicroseconds(unsigned int us);
+unsigned long millis(void);
+unsigned long micros(void);
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// Ports; a test drives the inputs by writing the PIN registers
+extern volatile uint8_t PORTB, PORTC, PORTD;
+extern volatile uint8_t PINB, PINC, PIND;
+extern volatile uint8_t PCICR, PCMSK0, PCMSK1, PCMSK2;
+
+// Timer2
+extern volatile uint8_t TCCR2A, TCCR2B, OCR2A, TCNT2, TIMSK2;
+#define WGM21 1
+#define CS22 2
+#define OCIE2A 1
+
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in: the EEPROM is RAM (defined in Arduino.cpp), erased as a new part is
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+    template <typename T> T &get(int address, T &value) { memcpy(&value, cells + address, sizeof(T)); return value; }
+    template <typename T> const T &put(int address, const T &value) { memcpy(cells + address, &value, sizeof(T)); return value; }
+    uint8_t read(int address) { return cells[address]; }
+    void update(int address, uint8_t value) { cells[address] = value; }
+
+    uint8_t cells[1024];
+};
+extern EEPROMClass EEPROM;
@@ -0,0 +1,9 @@
+#pragma once
+// Host stand-in: the display accepts every call and shows nothing
+#include <Arduino.h>
+
+class LiquidCrystal : public Print {
+public:
+    void clear(void) {}
+    void setCursor(uint8_t, uint8_t) {}
+};
@@ -0,0 +1,9 @@
+#pragma once
+// Host stand-in: the I2C bus is only named by the sensor driver, and its clock set
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    void setClock(uint32_t) {}
+};
+extern TwoWire Wire;
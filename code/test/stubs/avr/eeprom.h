@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in: writes to the RAM EEPROM of EEPROM.h complete at once
+#include <EEPROM.h>
+
+inline bool eeprom_is_ready(void) {
+    return true;
+}
+
+inline void eeprom_update_block(const void *data, void *address, size_t length) {
+    memcpy(EEPROM.cells + reinterpret_cast<uintptr_t>(address), data, length);
+}
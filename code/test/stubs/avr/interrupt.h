@@ -0,0 +1,3 @@
+#pragma once
+// Host stand-in: an interrupt handler is an ordinary function the test calls
+#define ISR(vector) extern "C" void vector(void)
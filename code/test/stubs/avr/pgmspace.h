@@ -0,0 +1,10 @@
+#pragma once
+// Host stand-in: program memory is ordinary memory
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
+#define pgm_read_word(address) (*reinterpret_cast<const uint16_t*>(address))
+#define pgm_read_ptr(address) (*reinterpret_cast<void* const*>(address))
+#define memcpy_P memcpy
@@ -0,0 +1,4 @@
+#pragma once
+// Host stand-in: tests run on one thread and call interrupt handlers themselves
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_BLOCK(type) for (int atomic_once = 1; atomic_once; atomic_once = 0)
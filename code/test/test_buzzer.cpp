@@ -0,0 +1,174 @@
+/**
+ * @file test_buzzer.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host test of the BuzzerTask request queue and pre-emption.
+ *
+ * Steps the Timer2 interrupt handler once per simulated millisecond while it is enabled, makes
+ * play() and mute() requests at set times, and compares the times the buzzer pin changed with
+ * the expected timeline.
+ */
+
+#include <Arduino.h>
+
+#include "BuzzerTask.h"
+
+extern "C" void TIMER2_COMPA_vect(void);
+
+namespace {
+
+    constexpr uint8_t BUZZER_PIN = 2;
+    constexpr uint8_t MAX_EDGES = 32;
+
+    /// Request made at a given time
+    struct request {
+        uint16_t time;          // Milliseconds
+        uint8_t pattern;        // BEEP_PATTERN, or MUTE_REQUEST
+    };
+    constexpr uint8_t MUTE_REQUEST = 0xFF;
+
+    /// Times the buzzer turned on and off
+    struct timeline {
+        uint16_t on[MAX_EDGES];
+        uint16_t off[MAX_EDGES];
+        uint8_t beeps;
+        uint16_t idle;          // Time the interrupt disabled itself; 0 if it never did
+    };
+
+    bool buzzing(void) {
+        return PORTD & digitalPinToBitMask(BUZZER_PIN);
+    }
+
+    /**
+    * @brief Records a change of the buzzer pin.
+    *
+    * @param result     Timeline to add to
+    * @param was        Buzzer state last recorded; updated
+    * @param now        Time of the change
+    */
+    void record(timeline &result, bool &was, const uint16_t now) {
+        if (buzzing() == was || result.beeps >= MAX_EDGES) {
+            return;
+        }
+        if (buzzing()) {
+            result.on[result.beeps] = now;
+        }
+        else {
+            result.off[result.beeps++] = now;
+        }
+        was = buzzing();
+    }
+
+    /**
+    * @brief Runs requests against the buzzer task and records what the buzzer did.
+    *
+    * @param requests   Requests, in time order
+    * @param count      Number of requests
+    * @param until      Milliseconds to run for
+    */
+    timeline replay(const request requests[], const uint8_t count, const uint16_t until) {
+        timeline result = {};
+        auto next = uint8_t{0};
+        auto was = false;
+        for (auto now = uint16_t{0}; now < until; now++) {
+            while (next < count && requests[next].time == now) {
+                if (requests[next].pattern == MUTE_REQUEST) {
+                    BuzzerTask::mute();
+                }
+                else {
+                    BuzzerTask::play(requests[next].pattern);
+                }
+                next++;
+            }
+            // Requests sound at once; the interrupt changes the buzzer at the end of the millisecond
+            record(result, was, now);
+            if (TIMSK2 & bit(OCIE2A)) {
+                TIMER2_COMPA_vect();
+                record(result, was, now + 1);
+                if (!(TIMSK2 & bit(OCIE2A))) {
+                    result.idle = now + 1;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+    * @brief Compares a timeline with the expected beeps, and prints it.
+    *
+    * @param name       Test name
+    * @param actual     Timeline recorded
+    * @param on         Expected times each beep started
+    * @param off        Expected times each beep ended
+    * @param beeps      Expected number of beeps
+    * @param idle       Expected time the interrupt disabled itself
+    *
+    * @return True if the timeline is as expected
+    */
+    bool check(const char *name, const timeline &actual, const uint16_t on[], const uint16_t off[],
+               const uint8_t beeps, const uint16_t idle) {
+        auto pass = actual.beeps == beeps && actual.idle == idle;
+        for (auto n = uint8_t{0}; pass && n < beeps; n++) {
+            pass = actual.on[n] == on[n] && actual.off[n] == off[n];
+        }
+        printf("%s %s:", pass ? "PASS" : "FAIL", name);
+        for (auto n = uint8_t{0}; n < actual.beeps; n++) {
+            printf(" %u-%u", actual.on[n], actual.off[n]);
+        }
+        printf(", idle at %u ms\n", actual.idle);
+        return pass;
+    }
+
+    /**
+    * @brief Calibration done, interrupted by an over range alarm, then muted.
+    *
+    * The alarm pre-empts the first blip of the calibration pattern (so the buzzer stays on
+    * from 0 to 70 ms), the calibration pattern is replayed from its start one off time later,
+    * and the mute confirmation follows it; the mute request flushes nothing else.
+    */
+    bool preemptAndMute(void) {
+        const request requests[] = {
+            {0, PATTERN_CALIBRATED},
+            {20, PATTERN_OVER_RANGE},
+            {200, MUTE_REQUEST},
+            {250, PATTERN_BUTTON},          // Muted; ignored
+        };
+        const uint16_t on[] = {0, 120, 220, 320, 420, 520};
+        const uint16_t off[] = {70, 170, 270, 370, 470, 570};
+        const timeline actual = replay(requests, sizeof(requests) / sizeof(requests[0]), 1000);
+        const bool pass = check("pre-empt and mute", actual, on, off, sizeof(on) / sizeof(on[0]), 570);
+        BuzzerTask::unmute();
+        (void) replay(nullptr, 0, 1000);
+        return pass && !BuzzerTask::muted();
+    }
+
+    /**
+    * @brief Queued requests play by priority, and repeated requests coalesce.
+    *
+    * The fault alarm pre-empts the ready beep, which is requeued ahead of the button beep
+    * already waiting; the repeated fault and button requests are dropped.
+    */
+    bool priorityAndCoalesce(void) {
+        const request requests[] = {
+            {0, PATTERN_READY},
+            {5, PATTERN_BUTTON},
+            {10, PATTERN_FAULT},
+            {15, PATTERN_FAULT},            // Playing; dropped
+            {20, PATTERN_BUTTON},           // Queued; dropped
+        };
+        const uint16_t on[] = {0, 560, 1110, 1660, 1810};
+        const uint16_t off[] = {510, 1060, 1610, 1760, 1860};
+        const timeline actual = replay(requests, sizeof(requests) / sizeof(requests[0]), 2500);
+        return check("priority and coalesce", actual, on, off, sizeof(on) / sizeof(on[0]), 1860);
+    }
+
+}
+
+int main(void) {
+    BuzzerTask::setup(BUZZER_PIN, HIGH, LOW);
+    auto pass = preemptAndMute();
+    pass = priorityAndCoalesce() && pass;
+    return pass ? 0 : 1;
+}
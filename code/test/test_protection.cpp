@@ -0,0 +1,153 @@
+/**
+ * @file test_protection.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host test of the over-current trip driven by the ALERT pin change interrupt.
+ *
+ * The ALERT lines (A0 and A1, on PINC) are driven by writing the stubbed PINC and the pin
+ * change interrupt handler is called as the hardware would; the trip output (pin 8, on PORTB)
+ * is checked after each step. The sensors are not simulated: the Monitor task functions that
+ * set and release their latch are stand-ins that count calls.
+ */
+
+#include <Arduino.h>
+
+#include "MonitorTask.h"
+#include "Protection.h"
+
+extern "C" void PCINT1_vect(void);
+
+namespace {
+
+    constexpr uint8_t TRIP_PIN = 8;
+    constexpr uint8_t LINES = 0x03;     // PINC bits of A0 and A1; high when idle
+
+    const monitor_output outputs[MONITOR_OUTPUTS] PROGMEM = {
+        {0x40, false, '+', A0},
+        {0x41, true, '-', A1},
+    };
+
+    // As above, but the negative output's ALERT is on pin 9 (PORTB), whose interrupt is not handled
+    const monitor_output wrongPort[MONITOR_OUTPUTS] PROGMEM = {
+        {0x40, false, '+', A0},
+        {0x41, true, '-', 9},
+    };
+
+    auto alertsSet = uint8_t{0};
+    auto alertsCleared = uint8_t{0};
+
+    bool tripOutput(void) {
+        return PORTB & digitalPinToBitMask(TRIP_PIN);
+    }
+
+    /**
+    * @brief Checks the trip state against the expected state, and prints the step.
+    *
+    * @param name       Test name
+    * @param step       What was done
+    * @param expected   True if the trip should be active
+    *
+    * @return True if both the trip output and Protection::tripped() match
+    */
+    bool check(const char *name, const char *step, const bool expected) {
+        const bool pass = tripOutput() == expected && Protection::tripped() == expected;
+        printf("%s %s: %s, trip %s\n", pass ? "PASS" : "FAIL", name, step, tripOutput() ? "active" : "released");
+        return pass;
+    }
+
+    /**
+    * @brief Starts from power up: lines idle, then sampled, then the trip armed.
+    *
+    * @param before   PINC when the lines are sampled, before the sensors are set up
+    * @param table    Sensor of each output
+    *
+    * @return Result of Protection::setup()
+    */
+    bool start(const uint8_t before, const monitor_output table[]) {
+        PORTB = 0;
+        PCICR = 0;
+        PCMSK0 = 0;
+        PCMSK1 = 0;
+        PINC = before;
+        Protection::sample(table);
+        PINC = LINES;                   // Setting the sensors up releases any latch
+        return Protection::setup(TRIP_PIN, table, 1100);
+    }
+
+    /**
+    * @brief An ALERT trips the output from the interrupt handler; the trip stays latched
+    *        when the line is released, and only reset() releases it, once no line is asserted.
+    */
+    bool tripAndReset(void) {
+        const bool armed = start(LINES, outputs);
+        auto pass = check("trip and reset", "armed", false);
+        pass = pass && armed && alertsSet == 1 && PCMSK1 == LINES && PCICR == bit(PCIE1);
+
+        PINC = LINES & ~0x02;
+        PCINT1_vect();
+        pass = check("trip and reset", "A1 asserted", true) && pass;
+
+        PINC = LINES;
+        PCINT1_vect();
+        pass = check("trip and reset", "A1 released", true) && pass;
+
+        PINC = LINES & ~0x01;
+        pass = !Protection::reset() && pass;
+        pass = check("trip and reset", "reset with A0 asserted", true) && pass;
+
+        PINC = LINES;
+        const auto cleared = alertsCleared;
+        pass = Protection::reset() && alertsCleared == cleared + 1 && pass;
+        pass = check("trip and reset", "reset with lines idle", false) && pass;
+
+        // A pin change that leaves every line idle does not trip
+        PCINT1_vect();
+        return check("trip and reset", "idle pin change", false) && pass;
+    }
+
+    /**
+    * @brief An ALERT latched before the reset trips as soon as the trip is armed, although
+    *        setting the sensors up released it.
+    */
+    bool latchedAcrossReset(void) {
+        (void) start(LINES & ~0x01, outputs);
+        auto pass = check("latched across reset", "armed after A0 latched", true);
+        pass = Protection::reset() && pass;
+        return check("latched across reset", "reset", false) && pass;
+    }
+
+    /**
+    * @brief An ALERT pin on a port whose interrupt is not handled is refused; nothing is armed.
+    */
+    bool wrongPortRefused(void) {
+        const auto set = alertsSet;
+        const bool armed = start(LINES, wrongPort);
+        const bool pass = !armed && alertsSet == set && PCICR == 0 && PCMSK0 == 0 && PCMSK1 == 0;
+        printf("%s wrong port: setup %s, %s\n", pass ? "PASS" : "FAIL", armed ? "armed" : "refused",
+               (PCICR == 0) ? "no pin change interrupt enabled" : "pin change interrupt enabled");
+        return pass;
+    }
+
+}
+
+// Stand-ins for the Monitor task, which owns the sensors
+namespace MonitorTask {
+
+    void setOverCurrentAlert(const int16_t) {
+        alertsSet++;
+    }
+
+    void clearOverCurrentAlert(void) {
+        alertsCleared++;
+    }
+
+}
+
+int main(void) {
+    auto pass = tripAndReset();
+    pass = latchedAcrossReset() && pass;
+    pass = wrongPortRefused() && pass;
+    return pass ? 0 : 1;
+}
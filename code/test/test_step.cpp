@@ -0,0 +1,136 @@
+/**
+ * @file test_step.cpp
+ * @copyright
+ * Copyright 2024 Gregory Aicklen.
+ * Licensed under the MIT License
+ *
+ * @brief Host test of the load step analysis with synthetic traces.
+ *
+ * Each trace is a 5V output sampled every 300us, with a load step after 50 sample sets. The
+ * response of the voltage to the step differs between traces.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "StepAnalysis.h"
+
+namespace {
+
+    constexpr uint32_t SAMPLE_PERIOD = 300;     // us
+    constexpr uint16_t STEP_AT = 50;            // Sample set at which the load changes
+    constexpr int16_t THRESHOLD = 100;          // mA
+    constexpr int16_t BAND = 25;                // mV
+
+    /// Voltage in mV, @p t sample sets after the step
+    typedef double (*response)(double t);
+
+    /**
+    * @brief Feeds a trace to the analysis until a step has been analysed, or the trace ends.
+    *
+    * @param before         Current before the step, in mA
+    * @param after          Current after the step, in mA
+    * @param voltage        Voltage after the step
+    * @param[out] result    Returns the result
+    *
+    * @return True if a step was analysed
+    */
+    bool run(const int16_t before, const int16_t after, response voltage, step_result &result) {
+        step_analyzer a;
+        StepAnalysis::reset(a, before, 5000);
+        for (auto n = uint16_t{0}; n < STEP_AT + 2 * STEP_WINDOW; n++) {
+            const int16_t current = (n < STEP_AT) ? before : after;
+            const int16_t mv = (n < STEP_AT) ? 5000 : static_cast<int16_t>(lround(voltage(n - STEP_AT)));
+            if (StepAnalysis::analyze(a, current, mv, n * SAMPLE_PERIOD, THRESHOLD, BAND)) {
+                result = a.current;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+    * @brief Prints the result of a test.
+    *
+    * @param name     Test name
+    * @param pass     True if the result is as expected
+    * @param result   Result of the analysis
+    *
+    * @return @p pass
+    */
+    bool check(const char *name, const bool pass, const step_result &result) {
+        printf("%s %s: step %d mA, droop %d mV, overshoot %d mV, settling %lu us, %s\n",
+               pass ? "PASS" : "FAIL", name, result.step, result.droop, result.overshoot,
+               static_cast<unsigned long>(result.settling), result.settled ? "settled" : "not settled");
+        return pass;
+    }
+
+    double ringing(double t) {
+        return 5000 - 120 * exp(-t / 10) * cos(t / 8);
+    }
+
+    double poorRegulation(double) {
+        return 5000 - 40;
+    }
+
+    double release(double t) {
+        return 5000 + 60 * exp(-t / 20);
+    }
+
+    double small(double) {
+        return 4990;
+    }
+
+    /**
+    * @brief Load increase with a damped ring: droops, overshoots slightly and settles.
+    *
+    * The ring is outside the band until 8 sample sets after the step (2400us).
+    */
+    bool ringingStep(void) {
+        step_result result = {};
+        const bool analysed = run(100, 600, ringing, result);
+        return check("ringing step", analysed && result.step == 500 && result.droop == 120 &&
+                     result.overshoot == 13 && result.settling == 2400 && result.settled, result);
+    }
+
+    /**
+    * @brief Load increase on an output whose load regulation is worse than the band: never settles.
+    */
+    bool notSettled(void) {
+        step_result result = {};
+        const bool analysed = run(100, 600, poorRegulation, result);
+        return check("not settled", analysed && result.droop == 40 && result.overshoot == 0 &&
+                     !result.settled, result);
+    }
+
+    /**
+    * @brief Load release: the current falls and the voltage overshoots, then settles.
+    *
+    * 60mV decaying with a time constant of 20 sample sets is last outside the band 17 sample
+    * sets after the step (5100us).
+    */
+    bool loadRelease(void) {
+        step_result result = {};
+        const bool analysed = run(800, 200, release, result);
+        return check("load release", analysed && result.step == -600 && result.droop == 0 &&
+                     result.overshoot == 60 && result.settling == 5100 && result.settled, result);
+    }
+
+    /**
+    * @brief A change in current smaller than the threshold is not a step.
+    */
+    bool belowThreshold(void) {
+        step_result result = {};
+        const bool analysed = run(100, 150, small, result);
+        return check("below threshold", !analysed, result);
+    }
+
+}
+
+int main(void) {
+    auto pass = ringingStep();
+    pass = notSettled() && pass;
+    pass = loadRelease() && pass;
+    pass = belowThreshold() && pass;
+    return pass ? 0 : 1;
+}